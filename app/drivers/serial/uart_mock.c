@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_uart_mock
+
+#include <device.h>
+#include <drivers/uart.h>
+
+struct uart_mock_config {
+    const uint8_t *rx_data;
+    size_t rx_len;
+};
+
+struct uart_mock_data {
+    size_t rx_index;
+};
+
+static int uart_mock_poll_in(const struct device *dev, unsigned char *c) {
+    const struct uart_mock_config *cfg = dev->config;
+    struct uart_mock_data *data = dev->data;
+
+    if (data->rx_index >= cfg->rx_len) {
+        return -1;
+    }
+
+    *c = cfg->rx_data[data->rx_index++];
+    return 0;
+}
+
+// Written bytes go nowhere. The code under test can log what it sends.
+static void uart_mock_poll_out(const struct device *dev, unsigned char c) {}
+
+static int uart_mock_init(const struct device *dev) { return 0; }
+
+static const struct uart_driver_api uart_mock_driver_api = {
+    .poll_in = uart_mock_poll_in,
+    .poll_out = uart_mock_poll_out,
+};
+
+#define MOCK_INST_INIT(n)                                                                          \
+    static const uint8_t uart_mock_rx_data_##n[] = DT_INST_PROP(n, rx_data);                       \
+    static const struct uart_mock_config uart_mock_config_##n = {                                  \
+        .rx_data = uart_mock_rx_data_##n, .rx_len = sizeof(uart_mock_rx_data_##n)};                \
+    static struct uart_mock_data uart_mock_data_##n;                                               \
+    DEVICE_DT_INST_DEFINE(n, uart_mock_init, NULL, &uart_mock_data_##n, &uart_mock_config_##n,     \
+                          PRE_KERNEL_1, CONFIG_SERIAL_INIT_PRIORITY, &uart_mock_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(MOCK_INST_INIT)
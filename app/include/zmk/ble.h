@@ -11,11 +11,11 @@
 
 #define ZMK_BLE_IS_CENTRAL                                                                         \
     (IS_ENABLED(CONFIG_ZMK_SPLIT) && IS_ENABLED(CONFIG_ZMK_BLE) &&                                 \
-     IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
+     IS_ENABLED(CONFIG_ZMK_SPLIT_BLE) && IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
 
 #if ZMK_BLE_IS_CENTRAL
-#define ZMK_BLE_PROFILE_COUNT (CONFIG_BT_MAX_PAIRED - 1)
-#define ZMK_BLE_SPLIT_PERIPHERAL_COUNT 1
+#define ZMK_BLE_SPLIT_PERIPHERAL_COUNT CONFIG_ZMK_SPLIT_BLE_CENTRAL_PERIPHERALS
+#define ZMK_BLE_PROFILE_COUNT (CONFIG_BT_MAX_PAIRED - ZMK_BLE_SPLIT_PERIPHERAL_COUNT)
 #else
 #define ZMK_BLE_PROFILE_COUNT CONFIG_BT_MAX_PAIRED
 #endif
@@ -29,10 +29,21 @@ int zmk_ble_active_profile_index();
 bt_addr_le_t *zmk_ble_active_profile_addr();
 bool zmk_ble_active_profile_is_open();
 bool zmk_ble_active_profile_is_connected();
+// Returns a new reference to the active profile's connection, or NULL. Release with bt_conn_unref.
+struct bt_conn *zmk_ble_active_profile_conn();
+uint16_t zmk_ble_active_profile_conn_interval();
 char *zmk_ble_active_profile_name();
 
 int zmk_ble_unpair_all();
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
-void zmk_ble_set_peripheral_addr(bt_addr_le_t *addr);
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+// Lets reconnect timing include the first report delivered to the host.
+void zmk_ble_reconnect_report_sent();
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT) */
+
+#if ZMK_BLE_IS_CENTRAL
+// Remembers a peripheral's address, returning its index or -ENOMEM if all are taken.
+int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr);
+// Returns the address of a known peripheral, or NULL if there isn't one at that index.
+const bt_addr_le_t *zmk_ble_get_peripheral_addr(uint8_t index);
+#endif /* ZMK_BLE_IS_CENTRAL */
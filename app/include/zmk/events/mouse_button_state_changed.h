@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+#include <zmk/event_manager.h>
+#include <zmk/hid.h>
+
+struct zmk_mouse_button_state_changed {
+    zmk_mouse_button_flags_t buttons;
+    bool state;
+    int64_t timestamp;
+};
+
+ZMK_EVENT_DECLARE(zmk_mouse_button_state_changed);
+
+static inline struct zmk_mouse_button_state_changed_event *
+zmk_mouse_button_state_changed_from_encoded(uint32_t encoded, bool pressed, int64_t timestamp) {
+    return new_zmk_mouse_button_state_changed((struct zmk_mouse_button_state_changed){
+        .buttons = encoded, .state = pressed, .timestamp = timestamp});
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+#include <zmk/event_manager.h>
+#include <zmk/mouse.h>
+#include <dt-bindings/zmk/mouse.h>
+
+struct zmk_mouse_scroll_state_changed {
+    int16_t max_speed_x;
+    int16_t max_speed_y;
+    struct zmk_mouse_movement_config config;
+    bool state;
+    int64_t timestamp;
+};
+
+ZMK_EVENT_DECLARE(zmk_mouse_scroll_state_changed);
+
+static inline struct zmk_mouse_scroll_state_changed_event *
+zmk_mouse_scroll_state_changed_from_encoded(uint32_t encoded,
+                                            const struct zmk_mouse_movement_config *config,
+                                            bool pressed, int64_t timestamp) {
+    return new_zmk_mouse_scroll_state_changed(
+        (struct zmk_mouse_scroll_state_changed){.max_speed_x = MOVE_HOR_DECODE(encoded),
+                                                .max_speed_y = MOVE_VERT_DECODE(encoded),
+                                                .config = *config,
+                                                .state = pressed,
+                                                .timestamp = timestamp});
+}
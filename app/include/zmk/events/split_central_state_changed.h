@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+#include <zmk/event_manager.h>
+
+// Raised on a peripheral when the central sends its state, so the peripheral's indicators can
+// follow it.
+struct zmk_split_central_state_changed {
+    uint32_t layers;
+    uint8_t endpoint;
+    uint8_t ble_profile;
+    // Central's battery state of charge, or UINT8_MAX if it doesn't report one.
+    uint8_t battery;
+};
+
+ZMK_EVENT_DECLARE(zmk_split_central_state_changed);
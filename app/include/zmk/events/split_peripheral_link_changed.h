@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+#include <zmk/event_manager.h>
+#include <zmk/split/bluetooth/central.h>
+
+struct zmk_split_peripheral_link_changed {
+    uint8_t source;
+    struct zmk_split_bt_link_stats stats;
+};
+
+ZMK_EVENT_DECLARE(zmk_split_peripheral_link_changed);
@@ -13,15 +13,41 @@
 #include <dt-bindings/zmk/hid_usage.h>
 #include <dt-bindings/zmk/hid_usage_pages.h>
 
+#if IS_ENABLED(CONFIG_ZMK_HID_KEYBOARD_NKRO_EXTENDED_REPORT)
+// Everything below the modifiers, which are reported in their own byte.
+#define ZMK_HID_KEYBOARD_NKRO_MAX_USAGE (HID_USAGE_KEY_KEYBOARD_LEFTCONTROL - 1)
+#else
 #define ZMK_HID_KEYBOARD_NKRO_MAX_USAGE HID_USAGE_KEY_KEYPAD_EQUAL
+#endif
+
+#define ZMK_HID_KEYBOARD_HKRO_MAX_USAGE 0xFF
 
 #define COLLECTION_REPORT 0x03
 
+#define ZMK_HID_REPORT_ID_KEYBOARD 0x01
+#define ZMK_HID_REPORT_ID_CONSUMER 0x02
+#define ZMK_HID_REPORT_ID_MOUSE 0x03
+#define ZMK_HID_REPORT_ID_TELEMETRY 0x04
+
+#define ZMK_HID_MOUSE_NUM_BUTTONS 0x05
+
+// Short item with a two byte usage, needed for usages above 0xFF like AC Pan.
+#ifndef HID_USAGE16
+#define HID_USAGE16(a, b) 0x0A, a, b
+#endif
+
+// Short item with a two byte usage page, needed for vendor-defined pages.
+#ifndef HID_USAGE_PAGE16
+#define HID_USAGE_PAGE16(a, b) 0x06, a, b
+#endif
+
+#define ZMK_HID_TELEMETRY_PAYLOAD_SIZE 30
+
 static const uint8_t zmk_hid_report_desc[] = {
     HID_USAGE_PAGE(HID_USAGE_GEN_DESKTOP),
     HID_USAGE(HID_USAGE_GD_KEYBOARD),
     HID_COLLECTION(HID_COLLECTION_APPLICATION),
-    HID_REPORT_ID(0x01),
+    HID_REPORT_ID(ZMK_HID_REPORT_ID_KEYBOARD),
     HID_USAGE_PAGE(HID_USAGE_KEY),
     HID_USAGE_MIN8(HID_USAGE_KEY_KEYBOARD_LEFTCONTROL),
     HID_USAGE_MAX8(HID_USAGE_KEY_KEYBOARD_RIGHT_GUI),
@@ -67,7 +93,7 @@ static const uint8_t zmk_hid_report_desc[] = {
     HID_USAGE_PAGE(HID_USAGE_CONSUMER),
     HID_USAGE(HID_USAGE_CONSUMER_CONSUMER_CONTROL),
     HID_COLLECTION(HID_COLLECTION_APPLICATION),
-    HID_REPORT_ID(0x02),
+    HID_REPORT_ID(ZMK_HID_REPORT_ID_CONSUMER),
     HID_USAGE_PAGE(HID_USAGE_CONSUMER),
 
 #if IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_BASIC)
@@ -89,6 +115,68 @@ static const uint8_t zmk_hid_report_desc[] = {
     /* INPUT (Data,Ary,Abs) */
     HID_INPUT(0x00),
     HID_END_COLLECTION,
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    HID_USAGE_PAGE(HID_USAGE_GD),
+    HID_USAGE(HID_USAGE_GD_MOUSE),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_REPORT_ID(ZMK_HID_REPORT_ID_MOUSE),
+    HID_USAGE(HID_USAGE_GD_POINTER),
+    HID_COLLECTION(HID_COLLECTION_PHYSICAL),
+
+    HID_USAGE_PAGE(HID_USAGE_BUTTON),
+    HID_USAGE_MIN8(0x01),
+    HID_USAGE_MAX8(ZMK_HID_MOUSE_NUM_BUTTONS),
+    HID_LOGICAL_MIN8(0x00),
+    HID_LOGICAL_MAX8(0x01),
+    HID_REPORT_SIZE(0x01),
+    HID_REPORT_COUNT(ZMK_HID_MOUSE_NUM_BUTTONS),
+    /* INPUT (Data,Var,Abs) */
+    HID_INPUT(0x02),
+
+    /* Pad the buttons out to a full byte */
+    HID_REPORT_SIZE(0x08 - ZMK_HID_MOUSE_NUM_BUTTONS),
+    HID_REPORT_COUNT(0x01),
+    /* INPUT (Cnst,Var,Abs) */
+    HID_INPUT(0x03),
+
+    HID_USAGE_PAGE(HID_USAGE_GD),
+    HID_USAGE(HID_USAGE_GD_X),
+    HID_USAGE(HID_USAGE_GD_Y),
+    HID_USAGE(HID_USAGE_GD_WHEEL),
+    HID_LOGICAL_MIN16(0x01, 0x80),
+    HID_LOGICAL_MAX16(0xFF, 0x7F),
+    HID_REPORT_SIZE(0x10),
+    HID_REPORT_COUNT(0x03),
+    /* INPUT (Data,Var,Rel) */
+    HID_INPUT(0x06),
+
+    HID_USAGE_PAGE(HID_USAGE_CONSUMER),
+    HID_USAGE16(0x38, 0x02), /* AC Pan */
+    HID_LOGICAL_MIN16(0x01, 0x80),
+    HID_LOGICAL_MAX16(0xFF, 0x7F),
+    HID_REPORT_SIZE(0x10),
+    HID_REPORT_COUNT(0x01),
+    /* INPUT (Data,Var,Rel) */
+    HID_INPUT(0x06),
+    HID_END_COLLECTION,
+    HID_END_COLLECTION,
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+    HID_USAGE_PAGE16(0x00, 0xFF), /* Vendor Defined 0xFF00 */
+    HID_USAGE(0x01),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_REPORT_ID(ZMK_HID_REPORT_ID_TELEMETRY),
+    HID_USAGE(0x02),
+    HID_LOGICAL_MIN8(0x00),
+    HID_LOGICAL_MAX16(0xFF, 0x00),
+    HID_REPORT_SIZE(0x08),
+    HID_REPORT_COUNT(ZMK_HID_TELEMETRY_PAYLOAD_SIZE + 2),
+    /* INPUT (Data,Var,Abs) */
+    HID_INPUT(0x02),
+    HID_END_COLLECTION,
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
 };
 
 // struct zmk_hid_boot_report
@@ -126,6 +214,42 @@ struct zmk_hid_consumer_report {
     struct zmk_hid_consumer_report_body body;
 } __packed;
 
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+typedef uint8_t zmk_mouse_button_flags_t;
+typedef uint8_t zmk_mouse_button_t;
+
+struct zmk_hid_mouse_report_body {
+    zmk_mouse_button_flags_t buttons;
+    int16_t x;
+    int16_t y;
+    int16_t scroll_y;
+    int16_t scroll_x;
+} __packed;
+
+struct zmk_hid_mouse_report {
+    uint8_t report_id;
+    struct zmk_hid_mouse_report_body body;
+} __packed;
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+// See zmk/telemetry.h for the frame types and their payloads.
+struct zmk_hid_telemetry_report_body {
+    uint8_t type;
+    uint8_t sequence;
+    uint8_t payload[ZMK_HID_TELEMETRY_PAYLOAD_SIZE];
+} __packed;
+
+struct zmk_hid_telemetry_report {
+    uint8_t report_id;
+    struct zmk_hid_telemetry_report_body body;
+} __packed;
+
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
 zmk_mod_flags_t zmk_hid_get_explicit_mods();
 int zmk_hid_register_mod(zmk_mod_t modifier);
 int zmk_hid_unregister_mod(zmk_mod_t modifier);
@@ -133,8 +257,8 @@ bool zmk_hid_mod_is_pressed(zmk_mod_t modifier);
 
 int zmk_hid_register_mods(zmk_mod_flags_t explicit_modifiers);
 int zmk_hid_unregister_mods(zmk_mod_flags_t explicit_modifiers);
-int zmk_hid_implicit_modifiers_press(zmk_mod_flags_t implicit_modifiers);
-int zmk_hid_implicit_modifiers_release();
+int zmk_hid_implicit_modifiers_press(uint32_t usage, zmk_mod_flags_t implicit_modifiers);
+int zmk_hid_implicit_modifiers_release(uint32_t usage);
 int zmk_hid_masked_modifiers_set(zmk_mod_flags_t masked_modifiers);
 int zmk_hid_masked_modifiers_clear();
 
@@ -152,5 +276,32 @@ int zmk_hid_press(uint32_t usage);
 int zmk_hid_release(uint32_t usage);
 bool zmk_hid_is_pressed(uint32_t usage);
 
+// Whether every usage pressed in `report` is also pressed in `other`, i.e. going from `report` to
+// `other` doesn't release anything.
+bool zmk_hid_keyboard_report_is_subset(const struct zmk_hid_keyboard_report_body *report,
+                                       const struct zmk_hid_keyboard_report_body *other);
+bool zmk_hid_consumer_report_is_subset(const struct zmk_hid_consumer_report_body *report,
+                                       const struct zmk_hid_consumer_report_body *other);
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+int zmk_hid_mouse_button_press(zmk_mouse_button_t button);
+int zmk_hid_mouse_button_release(zmk_mouse_button_t button);
+int zmk_hid_mouse_buttons_press(zmk_mouse_button_flags_t buttons);
+int zmk_hid_mouse_buttons_release(zmk_mouse_button_flags_t buttons);
+void zmk_hid_mouse_movement_add(int32_t x, int32_t y);
+void zmk_hid_mouse_scroll_add(int32_t x, int32_t y);
+bool zmk_hid_mouse_has_pending();
+bool zmk_hid_mouse_prepare_report();
+void zmk_hid_mouse_clear();
+// Adds the movement in `next` to `report` and takes its buttons, for sending the two as one. Fails,
+// leaving `report` as it was, if the movement doesn't fit in one report.
+bool zmk_hid_mouse_report_merge(struct zmk_hid_mouse_report_body *report,
+                                const struct zmk_hid_mouse_report_body *next);
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
 struct zmk_hid_keyboard_report *zmk_hid_get_keyboard_report();
 struct zmk_hid_consumer_report *zmk_hid_get_consumer_report();
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+struct zmk_hid_mouse_report *zmk_hid_get_mouse_report();
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
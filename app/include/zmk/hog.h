@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <bluetooth/conn.h>
+
 #include <zmk/keys.h>
 #include <zmk/hid.h>
 
@@ -13,3 +15,15 @@ int zmk_hog_init();
 
 int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *body);
 int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *body);
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+int zmk_hog_send_mouse_report(struct zmk_hid_mouse_report_body *body);
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+int zmk_hog_send_telemetry_report(struct zmk_hid_telemetry_report_body *body);
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+int zmk_hog_send_release_reports(struct bt_conn *conn);
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY) */
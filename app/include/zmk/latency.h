@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+
+struct zmk_latency_stats {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    // Upper edge of the histogram bucket holding the 99th percentile
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+// Sources are the same as for zmk_position_state_changed: ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL
+// for the local matrix, or the index of the peripheral a transition came from. The timestamp is the
+// one its position event carries, which ties the keycode change back to it. Latency is measured
+// from ticks.
+void zmk_latency_transition_detected(uint8_t source, int64_t timestamp, int64_t ticks);
+void zmk_latency_keycode_changed(uint16_t usage_page, int64_t timestamp);
+
+// Every keycode change bumps the sequence. A report remembers the sequence from when it was queued,
+// and passes it back once it's handed to an endpoint, so only the transitions it carries are
+// closed out.
+uint32_t zmk_latency_keycode_sequence();
+void zmk_latency_report_sent(uint16_t usage_page, uint32_t sequence);
+
+int zmk_latency_get_stats(uint8_t source, struct zmk_latency_stats *stats);
+// Copies up to count buckets of CONFIG_ZMK_LATENCY_PROBE_BUCKET_US each, and returns how many.
+int zmk_latency_get_histogram(uint8_t source, uint32_t *buckets, size_t count);
+void zmk_latency_reset();
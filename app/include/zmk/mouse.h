@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zmk/hid.h>
+
+struct zmk_mouse_movement_config {
+    // Time from key press until the configured speed is reached
+    uint16_t time_to_max_speed_ms;
+    // Shape of the acceleration curve: 0 is constant speed, 1 linear, 2 quadratic, ...
+    uint8_t acceleration_exponent;
+};
+
+int zmk_mouse_move(int16_t x, int16_t y);
+int zmk_mouse_scroll(int16_t x, int16_t y);
+int zmk_mouse_buttons_press(zmk_mouse_button_flags_t buttons);
+int zmk_mouse_buttons_release(zmk_mouse_button_flags_t buttons);
+void zmk_mouse_clear();
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <device.h>
+
+// Behaviors that can run on peripherals are identified by their index in a table built the same
+// way on both halves. The hash of the table lets the central check that the two agree.
+int zmk_split_behavior_id(const char *behavior_dev);
+const struct device *zmk_split_behavior_device(uint8_t id);
+uint32_t zmk_split_behaviors_hash();
+
+// Runs a behavior on behalf of the central, straight through its driver.
+int zmk_split_behavior_run(uint8_t id, uint32_t param1, uint32_t param2, uint32_t position,
+                           bool state);
@@ -1,8 +1,37 @@
-
 #pragma once
 
 #include <bluetooth/addr.h>
 #include <zmk/behavior.h>
 
 int zmk_split_bt_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
-                                 struct zmk_behavior_binding_event event, bool state);
\ No newline at end of file
+                                 struct zmk_behavior_binding_event event, bool state);
+
+#define ZMK_SPLIT_BT_RSSI_UNKNOWN INT8_MAX
+
+// Link quality for one peripheral. The counters run from when it connected, and the delays cover
+// the last CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL.
+struct zmk_split_bt_link_stats {
+    int8_t rssi;
+    // Connection interval in units of 1.25 ms, and supervision timeout in units of 10 ms.
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+    // What the link profile last asked for, which the link moves to at a later connection event.
+    uint16_t requested_interval;
+    uint16_t requested_latency;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    // Longest link layer payloads, in octets.
+    uint16_t tx_data_len;
+    uint16_t rx_data_len;
+    uint32_t notifications;
+    // Times a lost position event made us resynchronize.
+    uint32_t gaps;
+    // Position events dropped because the queue to the keymap was full.
+    uint32_t queue_overflows;
+    // From the key changing on the peripheral, by its clock, to the event being raised here.
+    uint16_t delay_avg_ms;
+    uint16_t delay_max_ms;
+};
+
+int zmk_split_bt_get_link_stats(uint8_t source, struct zmk_split_bt_link_stats *stats);
@@ -6,19 +6,65 @@
 
 #pragma once
 
-#define ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN 9
+#include <device.h>
+#include <zmk/split/behaviors.h>
 
+// Positions are sent as 15 bit values, with the top bit of the field holding the key state.
+#define ZMK_SPLIT_POSITION_MAX 0x7FFF
+#define ZMK_SPLIT_POSITION_EVENT_PRESSED BIT(15)
+
+// Position changes are notified as a batch of consecutive events. Every event gets the next 8 bit
+// sequence number, and a batch only carries the sequence number of its first event.
+struct zmk_split_position_event {
+    uint16_t position_state;
+    // Milliseconds between the key changing and the batch being sent, saturating at 255.
+    uint8_t age;
+} __packed;
+
+// Sized so a full batch fits in a notification with the default ATT MTU of 23.
+#define ZMK_SPLIT_POSITION_EVENTS_MAX 5
+
+struct zmk_split_position_events {
+    uint8_t sequence;
+    // Low 16 bits of the peripheral's uptime in milliseconds when the batch was sent, which the
+    // central uses to estimate the offset between the two clocks.
+    uint16_t timestamp;
+    struct zmk_split_position_event events[ZMK_SPLIT_POSITION_EVENTS_MAX];
+} __packed;
+
+// Read by the central to (re)synchronize, using a long read if it doesn't fit in the MTU. sequence
+// is that of the first event not yet reflected in position_state, which holds one bit for each of
+// the peripheral's position_count positions.
+struct zmk_split_position_snapshot {
+    uint8_t sequence;
+    uint16_t position_count;
+    uint8_t position_state[];
+} __packed;
+
+// Behaviors are identified by their index in a table built the same way on both halves, see
+// zmk_split_behavior_id(). A write to the run behavior characteristic holds one or more of
+// these, as many as fit in the MTU up to ZMK_SPLIT_RUN_BEHAVIOR_MAX. Reading it returns the
+// table's hash as a little endian uint32, which the central checks against its own.
 struct zmk_split_run_behavior_data {
-    uint8_t position;
+    uint8_t behavior_id;
     uint8_t state;
+    uint16_t position;
     uint32_t param1;
     uint32_t param2;
 } __packed;
 
-struct zmk_split_run_behavior_payload {
-    struct zmk_split_run_behavior_data data;
-    char behavior_dev[ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN];
+#define ZMK_SPLIT_RUN_BEHAVIOR_MAX 4
+
+// Written by the central whenever its state changes, see zmk_split_central_state_changed. Fields
+// are only ever appended, and the peripheral ignores any it doesn't know about.
+struct zmk_split_central_state {
+    uint32_t layers;
+    uint8_t endpoint;
+    uint8_t ble_profile;
+    uint8_t battery;
 } __packed;
 
-int zmk_split_bt_position_pressed(uint8_t position);
-int zmk_split_bt_position_released(uint8_t position);
\ No newline at end of file
+#define ZMK_SPLIT_CENTRAL_STATE_BATTERY_UNKNOWN UINT8_MAX
+
+int zmk_split_bt_position_pressed(uint32_t position, int64_t timestamp);
+int zmk_split_bt_position_released(uint32_t position, int64_t timestamp);
\ No newline at end of file
@@ -16,3 +16,5 @@
 #define ZMK_SPLIT_BT_SERVICE_UUID ZMK_BT_SPLIT_UUID(0x00000000)
 #define ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID ZMK_BT_SPLIT_UUID(0x00000001)
 #define ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID ZMK_BT_SPLIT_UUID(0x00000002)
+#define ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID ZMK_BT_SPLIT_UUID(0x00000003)
+#define ZMK_SPLIT_BT_CHAR_CENTRAL_STATE_UUID ZMK_BT_SPLIT_UUID(0x00000004)
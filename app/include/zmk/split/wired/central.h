@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zmk/behavior.h>
+
+#define ZMK_SPLIT_WIRED_IS_CENTRAL                                                                 \
+    (IS_ENABLED(CONFIG_ZMK_SPLIT) && IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED) &&                         \
+     IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
+
+int zmk_split_wired_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                                    struct zmk_behavior_binding_event event, bool state);
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/types.h>
+#include <sys/util.h>
+
+// Every frame is a start byte, the frame type, the payload length, the payload and a CRC-16/CCITT
+// of the type, length and payload, little endian. A receiver that loses sync skips ahead to the
+// next start byte whose frame passes the CRC.
+#define ZMK_SPLIT_WIRED_FRAME_START 0xA5
+#define ZMK_SPLIT_WIRED_FRAME_HEADER_LEN 3
+#define ZMK_SPLIT_WIRED_FRAME_CRC_LEN 2
+#define ZMK_SPLIT_WIRED_PAYLOAD_MAX UINT8_MAX
+#define ZMK_SPLIT_WIRED_FRAME_MAX                                                                  \
+    (ZMK_SPLIT_WIRED_FRAME_HEADER_LEN + ZMK_SPLIT_WIRED_PAYLOAD_MAX + ZMK_SPLIT_WIRED_FRAME_CRC_LEN)
+
+// The central asks for a snapshot this often, which doubles as a keepalive. Either half considers
+// the link lost once it hasn't heard from the other for ZMK_SPLIT_WIRED_LINK_TIMEOUT_MS.
+#define ZMK_SPLIT_WIRED_KEEPALIVE_MS 1000
+#define ZMK_SPLIT_WIRED_LINK_TIMEOUT_MS 3000
+
+enum zmk_split_wired_frame_type {
+    // Peripheral to central
+    ZMK_SPLIT_WIRED_FRAME_POSITION_EVENT = 0x01,
+    ZMK_SPLIT_WIRED_FRAME_SNAPSHOT = 0x02,
+    // Central to peripheral
+    ZMK_SPLIT_WIRED_FRAME_SYNC_REQUEST = 0x10,
+    ZMK_SPLIT_WIRED_FRAME_RUN_BEHAVIOR = 0x11,
+};
+
+// Positions are sent as 15 bit values, with the top bit of the field holding the key state.
+#define ZMK_SPLIT_WIRED_POSITION_MAX 0x7FFF
+#define ZMK_SPLIT_WIRED_POSITION_EVENT_PRESSED BIT(15)
+
+// Every event gets the next 8 bit sequence number, so the central notices a lost frame and asks for
+// a snapshot.
+struct zmk_split_wired_position_event {
+    uint8_t sequence;
+    uint16_t position_state;
+} __packed;
+
+// Sent in reply to a sync request, and unprompted when the peripheral starts. sequence is that of
+// the next position event, and position_state holds one bit for each of position_count positions.
+struct zmk_split_wired_snapshot {
+    uint32_t behaviors_hash;
+    uint8_t sequence;
+    uint16_t position_count;
+    uint8_t position_state[];
+} __packed;
+
+// behavior_id is the behavior's index in the table from zmk_split_behavior_id().
+struct zmk_split_wired_run_behavior {
+    uint8_t behavior_id;
+    uint8_t state;
+    uint16_t position;
+    uint32_t param1;
+    uint32_t param2;
+} __packed;
+
+// Queues a frame to send, returning -ENOMEM if the transmit buffer doesn't have room for all of it.
+int zmk_split_wired_send(uint8_t type, const void *payload, size_t len);
+
+// Implemented by the central or peripheral, and called from the system work queue for each frame
+// that arrives intact.
+void zmk_split_wired_handle_frame(uint8_t type, const uint8_t *payload, size_t len);
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr.h>
+
+// Telemetry is sent as a stream of vendor-defined HID reports. Each one carries a frame type, a
+// sequence number that increments with every frame so the host can spot lost ones, and one of the
+// payloads below. All multi-byte values are little endian. app/scripts/telemetry.py decodes them.
+
+#define ZMK_TELEMETRY_FRAME_COUNTERS 0x01
+#define ZMK_TELEMETRY_FRAME_LATENCY 0x02
+#define ZMK_TELEMETRY_FRAME_LATENCY_HISTOGRAM 0x03
+
+enum zmk_telemetry_counter {
+    ZMK_TELEMETRY_EVENTS_DISPATCHED,
+    ZMK_TELEMETRY_KSCAN_EVENTS,
+    ZMK_TELEMETRY_REPORTS_SENT,
+    // Merged into another queued report, so the host never saw the state on its own
+    ZMK_TELEMETRY_REPORTS_SUPPRESSED,
+    ZMK_TELEMETRY_REPORTS_DROPPED,
+    ZMK_TELEMETRY_COUNTER_COUNT,
+};
+
+enum zmk_telemetry_queue {
+    ZMK_TELEMETRY_QUEUE_KSCAN,
+    ZMK_TELEMETRY_QUEUE_USB,
+    ZMK_TELEMETRY_QUEUE_HOG,
+    ZMK_TELEMETRY_QUEUE_SPLIT,
+    ZMK_TELEMETRY_QUEUE_COUNT,
+};
+
+// Counters are totals since boot, and wrap around.
+struct zmk_telemetry_counters_frame {
+    uint32_t uptime_ms;
+    uint32_t counters[ZMK_TELEMETRY_COUNTER_COUNT];
+    uint8_t queue_high_water[ZMK_TELEMETRY_QUEUE_COUNT];
+} __packed;
+
+// One per latency source, see zmk/latency.h.
+struct zmk_telemetry_latency_frame {
+    uint8_t source;
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} __packed;
+
+#define ZMK_TELEMETRY_HISTOGRAM_FRAME_BUCKETS 12
+
+// A slice of a latency source's histogram, starting at first_bucket. Counts saturate at 0xFFFF.
+struct zmk_telemetry_histogram_frame {
+    uint8_t source;
+    uint8_t first_bucket;
+    uint8_t bucket_count;
+    uint16_t bucket_width_us;
+    uint16_t buckets[ZMK_TELEMETRY_HISTOGRAM_FRAME_BUCKETS];
+} __packed;
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+void zmk_telemetry_add(enum zmk_telemetry_counter counter, uint32_t value);
+void zmk_telemetry_queue_used(enum zmk_telemetry_queue queue, uint32_t used);
+
+#else
+
+static inline void zmk_telemetry_add(enum zmk_telemetry_counter counter, uint32_t value) {}
+static inline void zmk_telemetry_queue_used(enum zmk_telemetry_queue queue, uint32_t used) {}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
@@ -13,7 +13,7 @@ if [ $path = "all" ]; then
 	path="tests"
 fi
 
-testcases=$(find $path -name native_posix_64.keymap -exec dirname \{\} \;)
+testcases=$(find $path \( -name native_posix_64.keymap -o -name testcase.yaml \) -exec dirname \{\} \;)
 num_cases=$(echo "$testcases" | wc -l)
 if [ $num_cases -gt 1 ] || [ "$testcases" != "$path" ]; then
 	echo "" > ./build/tests/pass-fail.log
@@ -26,6 +26,24 @@ fi
 testcase="$path"
 echo "Running $testcase:"
 
+# Unit tests are standalone ztest applications rather than keymaps.
+if [ -f $testcase/testcase.yaml ]; then
+	west build -d build/$testcase -b native_posix_64 $testcase > /dev/null 2>&1
+	if [ $? -gt 0 ]; then
+		echo "FAILED: $testcase did not build" | tee -a ./build/tests/pass-fail.log
+		exit 1
+	fi
+
+	./build/$testcase/zephyr/zephyr.exe -stop_at=10 > build/$testcase/ztest.log 2>&1
+	if ! grep -q "PROJECT EXECUTION SUCCESSFUL" build/$testcase/ztest.log; then
+		echo "FAILED: $testcase" | tee -a ./build/tests/pass-fail.log
+		exit 1
+	fi
+
+	echo "PASS: $testcase" | tee -a ./build/tests/pass-fail.log
+	exit 0
+fi
+
 west build -d build/$testcase -b native_posix_64 -- -DZMK_CONFIG="$(pwd)/$testcase" > /dev/null 2>&1
 if [ $? -gt 0 ]; then
 	echo "FAILED: $testcase did not build" | tee -a ./build/tests/pass-fail.log
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The ZMK Contributors
+# SPDX-License-Identifier: MIT
+"""Reads the telemetry report enabled by CONFIG_ZMK_TELEMETRY from a Linux hidraw device."""
+
+import argparse
+import glob
+import os
+import struct
+import sys
+
+REPORT_ID = 0x04
+REPORT_SIZE = 33  # Report ID, frame type, sequence number and a 30 byte payload.
+
+# Usage Page (Vendor Defined 0xFF00), as it appears in the telemetry collection.
+VENDOR_USAGE_PAGE = bytes([0x06, 0x00, 0xFF])
+
+FRAME_COUNTERS = 0x01
+FRAME_LATENCY = 0x02
+FRAME_LATENCY_HISTOGRAM = 0x03
+
+# Latency sources are position state change sources, so peripherals are numbered from 0.
+SOURCE_LOCAL = 0xFF  # ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL
+
+COUNTER_NAMES = ["events", "kscan", "sent", "suppressed", "dropped"]
+QUEUE_NAMES = ["kscan", "usb", "hog", "split"]
+
+COUNTERS_FORMAT = "<I5I4B"
+LATENCY_FORMAT = "<B5I"
+HISTOGRAM_FORMAT = "<BBBH12H"
+
+
+def find_device():
+    for path in sorted(glob.glob("/sys/class/hidraw/hidraw*/device/report_descriptor")):
+        try:
+            with open(path, "rb") as f:
+                descriptor = f.read()
+        except OSError:
+            continue
+
+        if VENDOR_USAGE_PAGE in descriptor:
+            return os.path.join("/dev", path.split("/")[4])
+
+    return None
+
+
+def source_name(source):
+    return "local" if source == SOURCE_LOCAL else f"peripheral {source}"
+
+
+def print_counters(payload):
+    values = struct.unpack_from(COUNTERS_FORMAT, payload)
+    uptime, counters, queues = values[0], values[1:6], values[6:]
+
+    text = " ".join(f"{name}={value}" for name, value in zip(COUNTER_NAMES, counters))
+    queue_text = " ".join(f"{name}={value}" for name, value in zip(QUEUE_NAMES, queues))
+    print(f"[{uptime / 1000:10.3f}] counters {text} queue high water {queue_text}")
+
+
+def print_latency(payload):
+    source, count, min_us, avg_us, p99_us, max_us = struct.unpack_from(LATENCY_FORMAT, payload)
+    print(
+        f"{'':12} latency {source_name(source)}: n={count} min={min_us}us avg={avg_us}us "
+        f"p99={p99_us}us max={max_us}us"
+    )
+
+
+def print_histogram(payload):
+    values = struct.unpack_from(HISTOGRAM_FORMAT, payload)
+    source, first, count, width = values[:4]
+    buckets = values[4 : 4 + count]
+
+    for i, value in enumerate(buckets):
+        if value == 0:
+            continue
+        start = (first + i) * width
+        print(f"{'':12} histogram {source_name(source)}: {start:6}us+ {value}")
+
+
+HANDLERS = {
+    FRAME_COUNTERS: print_counters,
+    FRAME_LATENCY: print_latency,
+    FRAME_LATENCY_HISTOGRAM: print_histogram,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--device", help="hidraw device to read, e.g. /dev/hidraw3")
+    parser.add_argument(
+        "--histogram", action="store_true", help="print latency histograms as well as summaries"
+    )
+    args = parser.parse_args()
+
+    device = args.device or find_device()
+    if device is None:
+        sys.exit("No hidraw device with a ZMK telemetry report found. Try --device.")
+
+    print(f"Reading telemetry from {device}")
+
+    expected_sequence = None
+    with open(device, "rb") as f:
+        while True:
+            report = f.read(REPORT_SIZE)
+            if len(report) < REPORT_SIZE or report[0] != REPORT_ID:
+                continue
+
+            frame_type, sequence, payload = report[1], report[2], report[3:]
+
+            if expected_sequence is not None and sequence != expected_sequence:
+                lost = (sequence - expected_sequence) & 0xFF
+                print(f"{'':12} lost {lost} frame(s)")
+            expected_sequence = (sequence + 1) & 0xFF
+
+            if frame_type == FRAME_LATENCY_HISTOGRAM and not args.histogram:
+                continue
+
+            handler = HANDLERS.get(frame_type)
+            if handler is not None:
+                handler(payload)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
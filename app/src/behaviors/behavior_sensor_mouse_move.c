@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_behavior_sensor_mouse_move
+
+#include <device.h>
+#include <drivers/behavior.h>
+#include <logging/log.h>
+
+#include <drivers/sensor.h>
+#include <zmk/mouse.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+static int behavior_sensor_mouse_move_init(const struct device *dev) { return 0; };
+
+static int on_sensor_binding_triggered(struct zmk_behavior_binding *binding,
+                                       const struct device *sensor, int64_t timestamp) {
+    struct sensor_value dx, dy;
+    int err;
+
+    err = sensor_channel_get(sensor, SENSOR_CHAN_POS_DX, &dx);
+    if (err) {
+        LOG_WRN("Failed to get sensor X delta: %d", err);
+        return err;
+    }
+
+    err = sensor_channel_get(sensor, SENSOR_CHAN_POS_DY, &dy);
+    if (err) {
+        LOG_WRN("Failed to get sensor Y delta: %d", err);
+        return err;
+    }
+
+    return zmk_mouse_move(dx.val1, dy.val1);
+}
+
+static const struct behavior_driver_api behavior_sensor_mouse_move_driver_api = {
+    .sensor_binding_triggered = on_sensor_binding_triggered};
+
+#define SMM_INST(n)                                                                                \
+    DEVICE_DT_INST_DEFINE(n, behavior_sensor_mouse_move_init, NULL, NULL, NULL, APPLICATION,       \
+                          CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,                                     \
+                          &behavior_sensor_mouse_move_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SMM_INST)
+
+#endif /* DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT) */
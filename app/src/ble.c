@@ -36,6 +36,17 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/event_manager.h>
 #include <zmk/events/ble_active_profile_changed.h>
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+#include <zmk/hog.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+#include <zmk/activity.h>
+#include <zmk/events/activity_state_changed.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/sensor_event.h>
+#endif
+
 #if IS_ENABLED(CONFIG_ZMK_BLE_PASSKEY_ENTRY)
 #include <zmk/events/keycode_state_changed.h>
 
@@ -47,8 +58,8 @@ static uint8_t passkey_digit = 0;
 
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE_PASSKEY_ENTRY) */
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
-#define PROFILE_COUNT (CONFIG_BT_MAX_PAIRED - 1)
+#if ZMK_BLE_IS_CENTRAL
+#define PROFILE_COUNT (CONFIG_BT_MAX_PAIRED - ZMK_BLE_SPLIT_PERIPHERAL_COUNT)
 #else
 #define PROFILE_COUNT CONFIG_BT_MAX_PAIRED
 #endif
@@ -68,6 +79,11 @@ enum advertising_type {
 static struct zmk_ble_profile profiles[ZMK_BLE_PROFILE_COUNT];
 static uint8_t active_profile;
 
+// Connection to the active profile's host, holding a reference, or NULL when not connected. Kept
+// up to date from the connection callbacks so report sending doesn't need to search for it.
+static struct bt_conn *active_profile_conn;
+static struct k_spinlock active_profile_conn_lock;
+
 #define DEVICE_NAME CONFIG_BT_DEVICE_NAME
 #define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
 
@@ -82,11 +98,11 @@ static const struct bt_data zmk_ble_ad[] = {
                   ),
 };
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#if ZMK_BLE_IS_CENTRAL
 
-static bt_addr_le_t peripheral_addr;
+static bt_addr_le_t peripheral_addrs[ZMK_BLE_SPLIT_PERIPHERAL_COUNT];
 
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
+#endif /* ZMK_BLE_IS_CENTRAL */
 
 static void raise_profile_changed_event() {
     ZMK_EVENT_RAISE(new_zmk_ble_active_profile_changed((struct zmk_ble_active_profile_changed){
@@ -99,6 +115,41 @@ static void raise_profile_changed_event_callback(struct k_work *work) {
 
 K_WORK_DEFINE(raise_profile_changed_event_work, raise_profile_changed_event_callback);
 
+static void set_active_profile_conn(struct bt_conn *conn) {
+    k_spinlock_key_t key = k_spin_lock(&active_profile_conn_lock);
+    struct bt_conn *old_conn = active_profile_conn;
+    active_profile_conn = conn ? bt_conn_ref(conn) : NULL;
+    k_spin_unlock(&active_profile_conn_lock, key);
+
+    if (old_conn) {
+        bt_conn_unref(old_conn);
+    }
+}
+
+// Only needed when the active profile or its address changes, not for every report.
+static void refresh_active_profile_conn() {
+    struct bt_conn *conn = NULL;
+    bt_addr_le_t *addr = zmk_ble_active_profile_addr();
+
+    if (bt_addr_le_cmp(addr, BT_ADDR_LE_ANY)) {
+        conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr);
+    }
+
+    set_active_profile_conn(conn);
+
+    if (conn) {
+        bt_conn_unref(conn);
+    }
+}
+
+struct bt_conn *zmk_ble_active_profile_conn() {
+    k_spinlock_key_t key = k_spin_lock(&active_profile_conn_lock);
+    struct bt_conn *conn = active_profile_conn ? bt_conn_ref(active_profile_conn) : NULL;
+    k_spin_unlock(&active_profile_conn_lock, key);
+
+    return conn;
+}
+
 bool zmk_ble_active_profile_is_open() {
     return !bt_addr_le_cmp(&profiles[active_profile].peer, BT_ADDR_LE_ANY);
 }
@@ -114,14 +165,15 @@ void set_profile_address(uint8_t index, const bt_addr_le_t *addr) {
     LOG_DBG("Setting profile addr for %s to %s", log_strdup(setting_name), log_strdup(addr_str));
     settings_save_one(setting_name, &profiles[index], sizeof(struct zmk_ble_profile));
     k_work_submit(&raise_profile_changed_event_work);
+
+    if (index == active_profile) {
+        refresh_active_profile_conn();
+    }
 }
 
 bool zmk_ble_active_profile_is_connected() {
-    struct bt_conn *conn;
-    bt_addr_le_t *addr = zmk_ble_active_profile_addr();
-    if (!bt_addr_le_cmp(addr, BT_ADDR_LE_ANY)) {
-        return false;
-    } else if ((conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr)) == NULL) {
+    struct bt_conn *conn = zmk_ble_active_profile_conn();
+    if (conn == NULL) {
         return false;
     }
 
@@ -130,6 +182,90 @@ bool zmk_ble_active_profile_is_connected() {
     return true;
 }
 
+uint16_t zmk_ble_active_profile_conn_interval() {
+    struct bt_conn_info info;
+    struct bt_conn *conn = zmk_ble_active_profile_conn();
+    if (conn == NULL) {
+        return 0;
+    }
+
+    int err = bt_conn_get_info(conn, &info);
+    bt_conn_unref(conn);
+
+    return err ? 0 : info.le.interval;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+
+BUILD_ASSERT(CONFIG_ZMK_BLE_HOT_STANDBY_HOSTS <= ZMK_BLE_PROFILE_COUNT,
+             "Can't keep more hosts connected than there are profiles");
+BUILD_ASSERT(CONFIG_ZMK_BLE_HOT_STANDBY_HOSTS + (CONFIG_BT_MAX_PAIRED - ZMK_BLE_PROFILE_COUNT) <=
+                 CONFIG_BT_MAX_CONN,
+             "CONFIG_BT_MAX_CONN is too small for the number of hot standby hosts");
+
+static int profile_index_for_conn(struct bt_conn *conn) {
+    for (int i = 0; i < ZMK_BLE_PROFILE_COUNT; i++) {
+        if (bt_addr_le_cmp(&profiles[i].peer, BT_ADDR_LE_ANY) &&
+            !bt_addr_le_cmp(bt_conn_get_dst(conn), &profiles[i].peer)) {
+            return i;
+        }
+    }
+
+    return -ENODEV;
+}
+
+// Whether there's a bonded host that isn't connected, and room to keep it connected.
+static bool standby_slot_available() {
+    int bonded = 0;
+    int connected = 0;
+
+    for (int i = 0; i < ZMK_BLE_PROFILE_COUNT; i++) {
+        if (!bt_addr_le_cmp(&profiles[i].peer, BT_ADDR_LE_ANY)) {
+            continue;
+        }
+
+        bonded++;
+
+        struct bt_conn *conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, &profiles[i].peer);
+        if (conn) {
+            connected++;
+            bt_conn_unref(conn);
+        }
+    }
+
+    return connected < MIN(bonded, CONFIG_ZMK_BLE_HOT_STANDBY_HOSTS);
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+
+// Reconnecting to the active profile's host starts with high duty cycle directed advertising, which
+// the controller stops after 1.28 s, then low duty cycle directed advertising for a while, then
+// undirected advertising. Hosts using privacy may not answer directed advertising at all, which is
+// what the last stage is for.
+enum reconnect_stage {
+    RECONNECT_HIGH_DUTY,
+    RECONNECT_LOW_DUTY,
+    RECONNECT_UNDIRECTED,
+    RECONNECT_STAGE_COUNT,
+};
+
+static const char *reconnect_stage_str[] = {"high duty directed", "low duty directed",
+                                            "undirected"};
+
+static enum reconnect_stage reconnect_stage = RECONNECT_UNDIRECTED;
+
+#define ZMK_ADV_DIR_PARAM(addr)                                                                    \
+    (reconnect_stage == RECONNECT_HIGH_DUTY ? BT_LE_ADV_CONN_DIR(addr)                             \
+                                            : BT_LE_ADV_CONN_DIR_LOW_DUTY(addr))
+
+#else
+
+#define ZMK_ADV_DIR_PARAM(addr) BT_LE_ADV_CONN_DIR_LOW_DUTY(addr)
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT) */
+
 #define CHECKED_ADV_STOP()                                                                         \
     err = bt_le_adv_stop();                                                                        \
     advertising_status = ZMK_ADV_NONE;                                                             \
@@ -146,8 +282,7 @@ bool zmk_ble_active_profile_is_connected() {
         bt_conn_unref(conn);                                                                       \
         return 0;                                                                                  \
     }                                                                                              \
-    err = bt_le_adv_start(BT_LE_ADV_CONN_DIR_LOW_DUTY(addr), zmk_ble_ad, ARRAY_SIZE(zmk_ble_ad),   \
-                          NULL, 0);                                                                \
+    err = bt_le_adv_start(ZMK_ADV_DIR_PARAM(addr), zmk_ble_ad, ARRAY_SIZE(zmk_ble_ad), NULL, 0);   \
     if (err) {                                                                                     \
         LOG_ERR("Advertising failed to start (err %d)", err);                                      \
         return err;                                                                                \
@@ -179,7 +314,20 @@ int update_advertising() {
 
         // LOG_DBG("Directed advertising to %s", log_strdup(addr_str));
         // desired_adv = ZMK_ADV_DIR;
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+        if (reconnect_stage != RECONNECT_UNDIRECTED) {
+            desired_adv = ZMK_ADV_DIR;
+        }
+#endif
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+    // Keep advertising until the other bonded hosts have reconnected too, so that switching to
+    // them doesn't have to wait for a connection.
+    if (desired_adv == ZMK_ADV_NONE && standby_slot_available()) {
+        desired_adv = ZMK_ADV_CONN;
     }
+#endif
     LOG_DBG("advertising from %d to %d", advertising_status, desired_adv);
 
     switch (desired_adv + CURR_ADV(advertising_status)) {
@@ -211,6 +359,102 @@ static void update_advertising_callback(struct k_work *work) { update_advertisin
 
 K_WORK_DEFINE(update_advertising_work, update_advertising_callback);
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+
+struct reconnect_stats {
+    uint32_t count;
+    uint32_t connect_ms_total;
+    uint32_t first_report_count;
+    uint32_t first_report_ms_total;
+};
+
+// Indexed by the stage the connection was made in, to compare how well each one works
+static struct reconnect_stats reconnect_stats[RECONNECT_STAGE_COUNT];
+static int64_t reconnect_start;
+static enum reconnect_stage reconnect_connected_stage;
+static atomic_t reconnect_awaiting_report;
+
+static void reconnect_low_duty_timeout(struct k_work *work) {
+    if (reconnect_stage == RECONNECT_LOW_DUTY) {
+        LOG_DBG("Falling back to undirected advertising");
+        reconnect_stage = RECONNECT_UNDIRECTED;
+        update_advertising();
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(reconnect_low_duty_work, reconnect_low_duty_timeout);
+
+static void reconnect_start_stage(enum reconnect_stage stage) {
+    reconnect_stage = stage;
+
+    if (stage == RECONNECT_LOW_DUTY) {
+        k_work_reschedule(&reconnect_low_duty_work,
+                          K_MSEC(CONFIG_ZMK_BLE_FAST_RECONNECT_LOW_DUTY_DURATION));
+    } else {
+        k_work_cancel_delayable(&reconnect_low_duty_work);
+    }
+}
+
+// Called whenever the active profile's host needs to (re)connect, before advertising is updated.
+static void reconnect_begin() {
+    atomic_clear(&reconnect_awaiting_report);
+
+    if (zmk_ble_active_profile_is_open()) {
+        // Nothing to direct advertising to.
+        reconnect_start_stage(RECONNECT_UNDIRECTED);
+        return;
+    }
+
+    reconnect_start = k_uptime_get();
+    reconnect_start_stage(RECONNECT_HIGH_DUTY);
+}
+
+static void reconnect_high_duty_timed_out() {
+    if (reconnect_stage == RECONNECT_HIGH_DUTY) {
+        LOG_DBG("Falling back to low duty directed advertising");
+        reconnect_start_stage(RECONNECT_LOW_DUTY);
+    }
+}
+
+static void reconnect_connected() {
+    if (zmk_ble_active_profile_is_open()) {
+        return;
+    }
+
+    uint32_t elapsed = k_uptime_get() - reconnect_start;
+    struct reconnect_stats *stats = &reconnect_stats[reconnect_stage];
+
+    stats->count++;
+    stats->connect_ms_total += elapsed;
+    reconnect_connected_stage = reconnect_stage;
+    atomic_set(&reconnect_awaiting_report, 1);
+
+    LOG_INF("Reconnected in %u ms with %s advertising (average %u ms over %u)", elapsed,
+            reconnect_stage_str[reconnect_stage], stats->connect_ms_total / stats->count,
+            stats->count);
+
+    reconnect_start_stage(RECONNECT_UNDIRECTED);
+}
+
+void zmk_ble_reconnect_report_sent() {
+    if (!atomic_cas(&reconnect_awaiting_report, 1, 0)) {
+        return;
+    }
+
+    uint32_t elapsed = k_uptime_get() - reconnect_start;
+    struct reconnect_stats *stats = &reconnect_stats[reconnect_connected_stage];
+
+    stats->first_report_count++;
+    stats->first_report_ms_total += elapsed;
+
+    LOG_INF("First report %u ms after reconnecting started with %s advertising (average %u ms "
+            "over %u)",
+            elapsed, reconnect_stage_str[reconnect_connected_stage],
+            stats->first_report_ms_total / stats->first_report_count, stats->first_report_count);
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT) */
+
 int zmk_ble_clear_bonds() {
     LOG_DBG("");
 
@@ -227,6 +471,94 @@ int zmk_ble_clear_bonds() {
 
 int zmk_ble_active_profile_index() { return active_profile; }
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+
+enum conn_params_mode { CONN_PARAMS_NONE, CONN_PARAMS_ACTIVE, CONN_PARAMS_RELAXED };
+
+static const char *conn_params_mode_str[] = {"none", "active", "relaxed"};
+
+// What the keyboard wants, and what was last requested from the host. The requested mode and the
+// request time are only written from the system work queue.
+static enum conn_params_mode desired_conn_params = CONN_PARAMS_RELAXED;
+static enum conn_params_mode requested_conn_params = CONN_PARAMS_NONE;
+static int64_t last_conn_params_request;
+
+static void update_conn_params_work_handler(struct k_work *work) {
+    if (desired_conn_params == requested_conn_params) {
+        return;
+    }
+
+    // Hosts don't like being asked for new parameters over and over, so requests are spaced out.
+    // Whatever is desired by then is what gets requested.
+    int64_t wait_ms = last_conn_params_request + CONFIG_ZMK_BLE_CONN_PARAMS_MIN_UPDATE_INTERVAL -
+                      k_uptime_get();
+    if (wait_ms > 0) {
+        k_work_schedule(k_work_delayable_from_work(work), K_MSEC(wait_ms));
+        return;
+    }
+
+    struct bt_conn *conn = zmk_ble_active_profile_conn();
+    if (conn == NULL) {
+        return;
+    }
+
+    const struct bt_le_conn_param *param =
+        desired_conn_params == CONN_PARAMS_ACTIVE
+            ? BT_LE_CONN_PARAM(CONFIG_ZMK_BLE_ACTIVE_CONN_INTERVAL_MIN,
+                               CONFIG_ZMK_BLE_ACTIVE_CONN_INTERVAL_MAX,
+                               CONFIG_ZMK_BLE_ACTIVE_CONN_LATENCY,
+                               CONFIG_BT_PERIPHERAL_PREF_TIMEOUT)
+            : BT_LE_CONN_PARAM(CONFIG_ZMK_BLE_RELAXED_CONN_INTERVAL_MIN,
+                               CONFIG_ZMK_BLE_RELAXED_CONN_INTERVAL_MAX,
+                               CONFIG_ZMK_BLE_RELAXED_CONN_LATENCY,
+                               CONFIG_BT_PERIPHERAL_PREF_TIMEOUT);
+
+    LOG_DBG("Requesting %s connection parameters", conn_params_mode_str[desired_conn_params]);
+    int err = bt_conn_le_param_update(conn, param);
+    bt_conn_unref(conn);
+
+    if (err) {
+        LOG_WRN("Failed to request connection parameters (err %d)", err);
+        return;
+    }
+
+    requested_conn_params = desired_conn_params;
+    last_conn_params_request = k_uptime_get();
+}
+
+static K_WORK_DELAYABLE_DEFINE(update_conn_params_work, update_conn_params_work_handler);
+
+static void set_desired_conn_params(enum conn_params_mode mode) {
+    desired_conn_params = mode;
+    k_work_schedule(&update_conn_params_work, K_NO_WAIT);
+}
+
+static void conn_params_quiet_work_handler(struct k_work *work) {
+    set_desired_conn_params(CONN_PARAMS_RELAXED);
+}
+
+static K_WORK_DELAYABLE_DEFINE(conn_params_quiet_work, conn_params_quiet_work_handler);
+
+static void conn_params_input_detected() {
+    k_work_reschedule(&conn_params_quiet_work, K_MSEC(CONFIG_ZMK_BLE_CONN_PARAMS_QUIET_PERIOD));
+
+    if (desired_conn_params != CONN_PARAMS_ACTIVE) {
+        set_desired_conn_params(CONN_PARAMS_ACTIVE);
+    }
+}
+
+static void conn_params_reset_work_handler(struct k_work *work) {
+    // A new connection starts with whatever the host picked. Leave it alone for a while, then
+    // request what fits the current activity.
+    requested_conn_params = CONN_PARAMS_NONE;
+    last_conn_params_request = k_uptime_get();
+    set_desired_conn_params(desired_conn_params);
+}
+
+K_WORK_DEFINE(conn_params_reset_work, conn_params_reset_work_handler);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS) */
+
 #if IS_ENABLED(CONFIG_SETTINGS)
 static void ble_save_profile_work(struct k_work *work) {
     settings_save_one("ble/active_profile", &active_profile, sizeof(active_profile));
@@ -253,8 +585,30 @@ int zmk_ble_prof_select(uint8_t index) {
         return 0;
     }
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+    struct bt_conn *previous_conn = zmk_ble_active_profile_conn();
+#endif
+
     active_profile = index;
     ble_save_profile();
+    refresh_active_profile_conn();
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+    k_work_submit(&conn_params_reset_work);
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+    // The previous host stays connected, so it mustn't be left with keys held down.
+    if (previous_conn) {
+        zmk_hog_send_release_reports(previous_conn);
+        bt_conn_unref(previous_conn);
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+    if (!zmk_ble_active_profile_is_connected()) {
+        reconnect_begin();
+    }
+#endif
 
     update_advertising();
 
@@ -278,14 +632,37 @@ bt_addr_le_t *zmk_ble_active_profile_addr() { return &profiles[active_profile].p
 
 char *zmk_ble_active_profile_name() { return profiles[active_profile].name; }
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#if ZMK_BLE_IS_CENTRAL
+
+int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr) {
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        if (!bt_addr_le_cmp(&peripheral_addrs[i], addr)) {
+            return i;
+        }
+
+        if (!bt_addr_le_cmp(&peripheral_addrs[i], BT_ADDR_LE_ANY)) {
+            bt_addr_le_copy(&peripheral_addrs[i], addr);
+
+            char setting_name[27];
+            sprintf(setting_name, "ble/peripheral_addresses/%d", i);
+            settings_save_one(setting_name, addr, sizeof(bt_addr_le_t));
+            return i;
+        }
+    }
 
-void zmk_ble_set_peripheral_addr(bt_addr_le_t *addr) {
-    memcpy(&peripheral_addr, addr, sizeof(bt_addr_le_t));
-    settings_save_one("ble/peripheral_address", addr, sizeof(bt_addr_le_t));
+    return -ENOMEM;
 }
 
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
+const bt_addr_le_t *zmk_ble_get_peripheral_addr(uint8_t index) {
+    if (index >= ZMK_BLE_SPLIT_PERIPHERAL_COUNT ||
+        !bt_addr_le_cmp(&peripheral_addrs[index], BT_ADDR_LE_ANY)) {
+        return NULL;
+    }
+
+    return &peripheral_addrs[index];
+}
+
+#endif /* ZMK_BLE_IS_CENTRAL */
 
 #if IS_ENABLED(CONFIG_SETTINGS)
 
@@ -336,13 +713,31 @@ static int ble_profiles_handle_set(const char *name, size_t len, settings_read_c
             return err;
         }
     }
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
-    else if (settings_name_steq(name, "peripheral_address", &next) && !next) {
+#if ZMK_BLE_IS_CENTRAL
+    else if (settings_name_steq(name, "peripheral_addresses", &next) && next) {
+        char *endptr;
+        uint8_t idx = strtoul(next, &endptr, 10);
+        if (*endptr != '\0' || idx >= ZMK_BLE_SPLIT_PERIPHERAL_COUNT) {
+            LOG_WRN("Invalid peripheral index: %s", log_strdup(next));
+            return -EINVAL;
+        }
+
+        if (len != sizeof(bt_addr_le_t)) {
+            return -EINVAL;
+        }
+
+        int err = read_cb(cb_arg, &peripheral_addrs[idx], sizeof(bt_addr_le_t));
+        if (err <= 0) {
+            LOG_ERR("Failed to handle peripheral address from settings (err %d)", err);
+            return err;
+        }
+    } else if (settings_name_steq(name, "peripheral_address", &next) && !next) {
+        // Saved before more than one peripheral was supported.
         if (len != sizeof(bt_addr_le_t)) {
             return -EINVAL;
         }
 
-        int err = read_cb(cb_arg, &peripheral_addr, sizeof(bt_addr_le_t));
+        int err = read_cb(cb_arg, &peripheral_addrs[0], sizeof(bt_addr_le_t));
         if (err <= 0) {
             LOG_ERR("Failed to handle peripheral address from settings (err %d)", err);
             return err;
@@ -377,22 +772,45 @@ static void connected(struct bt_conn *conn, uint8_t err) {
 
     if (err) {
         LOG_WRN("Failed to connect to %s (%u)", log_strdup(addr), err);
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+        if (err == BT_HCI_ERR_ADV_TIMEOUT) {
+            reconnect_high_duty_timed_out();
+        }
+#endif
         update_advertising();
         return;
     }
 
     LOG_DBG("Connected %s", log_strdup(addr));
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+    // Advertising continues while the active profile is connected, but only to let bonded hosts
+    // back in. New hosts can only pair while the active profile is open.
+    if (!zmk_ble_active_profile_is_open() && profile_index_for_conn(conn) < 0) {
+        LOG_WRN("Disconnecting %s, which isn't bonded to any profile", log_strdup(addr));
+        bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        return;
+    }
+#endif
+
     if (bt_conn_set_security(conn, BT_SECURITY_L2)) {
         LOG_ERR("Failed to set security");
     }
 
-    update_advertising();
-
     if (is_conn_active_profile(conn)) {
         LOG_DBG("Active profile connected");
+        set_active_profile_conn(conn);
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+        reconnect_connected();
+#endif
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+        k_work_submit(&conn_params_reset_work);
+#endif
         k_work_submit(&raise_profile_changed_event_work);
     }
+
+    // Only once the active profile's connection is known, or advertising would restart for it.
+    update_advertising();
 }
 
 static void disconnected(struct bt_conn *conn, uint8_t reason) {
@@ -410,6 +828,13 @@ static void disconnected(struct bt_conn *conn, uint8_t reason) {
         return;
     }
 
+    if (conn == active_profile_conn) {
+        set_active_profile_conn(NULL);
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+        reconnect_begin();
+#endif
+    }
+
     // We need to do this in a work callback, otherwise the advertising update will still see the
     // connection for a profile as active, and not start advertising yet.
     k_work_submit(&update_advertising_work);
@@ -438,6 +863,14 @@ static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t l
 
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+    if (is_conn_active_profile(conn)) {
+        LOG_INF("%s: interval %d latency %d timeout %d (requested %s)", log_strdup(addr), interval,
+                latency, timeout, conn_params_mode_str[requested_conn_params]);
+        return;
+    }
+#endif
+
     LOG_DBG("%s: interval %d latency %d timeout %d", log_strdup(addr), interval, latency, timeout);
 }
 
@@ -544,6 +977,10 @@ static void zmk_ble_ready(int err) {
         return;
     }
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+    reconnect_begin();
+#endif
+
     update_advertising();
 }
 
@@ -671,3 +1108,29 @@ ZMK_SUBSCRIPTION(zmk_ble, zmk_keycode_state_changed);
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE_PASSKEY_ENTRY) */
 
 SYS_INIT(zmk_ble_init, APPLICATION, CONFIG_ZMK_BLE_INIT_PRIORITY);
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS)
+
+static int zmk_ble_conn_params_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *activity_ev = as_zmk_activity_state_changed(eh);
+    if (activity_ev) {
+        if (activity_ev->state != ZMK_ACTIVITY_ACTIVE) {
+            k_work_cancel_delayable(&conn_params_quiet_work);
+            set_desired_conn_params(CONN_PARAMS_RELAXED);
+        }
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    if (zmk_activity_get_state() == ZMK_ACTIVITY_ACTIVE) {
+        conn_params_input_detected();
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(zmk_ble_conn_params, zmk_ble_conn_params_listener);
+ZMK_SUBSCRIPTION(zmk_ble_conn_params, zmk_activity_state_changed);
+ZMK_SUBSCRIPTION(zmk_ble_conn_params, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(zmk_ble_conn_params, zmk_sensor_event);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_ACTIVITY_CONN_PARAMS) */
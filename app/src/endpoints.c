@@ -5,6 +5,7 @@
  */
 
 #include <init.h>
+#include <string.h>
 #include <settings/settings.h>
 
 #include <zmk/ble.h>
@@ -18,6 +19,10 @@
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/events/endpoint_selection_changed.h>
 
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+#include <zmk/mouse.h>
+#endif
+
 #include <logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -70,10 +75,30 @@ int zmk_endpoints_toggle() {
     return zmk_endpoints_select(new_endpoint);
 }
 
-static int send_keyboard_report() {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+
+#define ZMK_ENDPOINT_COUNT (ZMK_ENDPOINT_BLE + 1)
+
+// What each endpoint's host was last sent, so an endpoint that becomes ready can be brought up to
+// date without touching the other one.
+struct endpoint_report_state {
+    bool ready;
+    struct zmk_hid_keyboard_report_body keyboard;
+    struct zmk_hid_consumer_report_body consumer;
+};
+
+static struct endpoint_report_state endpoint_states[ZMK_ENDPOINT_COUNT];
+
+#endif /* IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR) */
+
+static int send_keyboard_report(enum zmk_endpoint endpoint) {
     struct zmk_hid_keyboard_report *keyboard_report = zmk_hid_get_keyboard_report();
 
-    switch (current_endpoint) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+    endpoint_states[endpoint].keyboard = keyboard_report->body;
+#endif
+
+    switch (endpoint) {
 #if IS_ENABLED(CONFIG_ZMK_USB)
     case ZMK_ENDPOINT_USB: {
         int err = zmk_usb_hid_send_report((uint8_t *)keyboard_report, sizeof(*keyboard_report));
@@ -95,15 +120,19 @@ static int send_keyboard_report() {
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
 
     default:
-        LOG_ERR("Unsupported endpoint %d", current_endpoint);
+        LOG_ERR("Unsupported endpoint %d", endpoint);
         return -ENOTSUP;
     }
 }
 
-static int send_consumer_report() {
+static int send_consumer_report(enum zmk_endpoint endpoint) {
     struct zmk_hid_consumer_report *consumer_report = zmk_hid_get_consumer_report();
 
-    switch (current_endpoint) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+    endpoint_states[endpoint].consumer = consumer_report->body;
+#endif
+
+    switch (endpoint) {
 #if IS_ENABLED(CONFIG_ZMK_USB)
     case ZMK_ENDPOINT_USB: {
         int err = zmk_usb_hid_send_report((uint8_t *)consumer_report, sizeof(*consumer_report));
@@ -125,19 +154,74 @@ static int send_consumer_report() {
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
 
     default:
-        LOG_ERR("Unsupported endpoint %d", current_endpoint);
+        LOG_ERR("Unsupported endpoint %d", endpoint);
+        return -ENOTSUP;
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+static int send_mouse_report(enum zmk_endpoint endpoint) {
+    struct zmk_hid_mouse_report *mouse_report = zmk_hid_get_mouse_report();
+
+    switch (endpoint) {
+#if IS_ENABLED(CONFIG_ZMK_USB)
+    case ZMK_ENDPOINT_USB: {
+        int err = zmk_usb_hid_send_report((uint8_t *)mouse_report, sizeof(*mouse_report));
+        if (err) {
+            LOG_ERR("FAILED TO SEND OVER USB: %d", err);
+        }
+        return err;
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    case ZMK_ENDPOINT_BLE: {
+        int err = zmk_hog_send_mouse_report(&mouse_report->body);
+        if (err) {
+            LOG_ERR("FAILED TO SEND OVER HOG: %d", err);
+        }
+        return err;
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+
+    default:
+        LOG_ERR("Unsupported endpoint %d", endpoint);
         return -ENOTSUP;
     }
 }
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+static int send_to_endpoints(int (*send)(enum zmk_endpoint endpoint)) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+    // USB and HOG each queue reports on their own, so a slow BLE link doesn't hold up USB. Report
+    // the last failure, but always try every ready endpoint.
+    int ret = 0;
+    for (int i = 0; i < ZMK_ENDPOINT_COUNT; i++) {
+        if (endpoint_states[i].ready) {
+            int err = send(i);
+            if (err) {
+                ret = err;
+            }
+        }
+    }
+    return ret;
+#else
+    return send(current_endpoint);
+#endif /* IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR) */
+}
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+int zmk_endpoints_send_mouse_report() { return send_to_endpoints(send_mouse_report); }
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
 
 int zmk_endpoints_send_report(uint16_t usage_page) {
 
     LOG_DBG("usage page 0x%02X", usage_page);
     switch (usage_page) {
     case HID_USAGE_KEY:
-        return send_keyboard_report();
+        return send_to_endpoints(send_keyboard_report);
     case HID_USAGE_CONSUMER:
-        return send_consumer_report();
+        return send_to_endpoints(send_consumer_report);
     default:
         LOG_ERR("Unsupported usage page %d", usage_page);
         return -ENOTSUP;
@@ -231,14 +315,58 @@ static void disconnect_current_endpoint() {
 
     zmk_endpoints_send_report(HID_USAGE_KEY);
     zmk_endpoints_send_report(HID_USAGE_CONSUMER);
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    zmk_mouse_clear();
+    zmk_endpoints_send_mouse_report();
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+}
+
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+static void sync_endpoint(enum zmk_endpoint endpoint, bool ready) {
+    struct endpoint_report_state *state = &endpoint_states[endpoint];
+
+    if (!ready) {
+        // The host releases everything it saw from a link that goes away.
+        *state = (struct endpoint_report_state){0};
+        return;
+    }
+
+    if (state->ready) {
+        return;
+    }
+
+    state->ready = true;
+    LOG_DBG("Endpoint %d ready, sending current state", endpoint);
+
+    if (memcmp(&state->keyboard, &zmk_hid_get_keyboard_report()->body, sizeof(state->keyboard))) {
+        send_keyboard_report(endpoint);
+    }
+    if (memcmp(&state->consumer, &zmk_hid_get_consumer_report()->body, sizeof(state->consumer))) {
+        send_consumer_report(endpoint);
+    }
 }
 
+static void update_mirrored_endpoints(const zmk_event_t *eh) {
+    // Switching profiles puts a different host behind the BLE endpoint, which has seen nothing.
+    if (as_zmk_ble_active_profile_changed(eh)) {
+        sync_endpoint(ZMK_ENDPOINT_BLE, false);
+    }
+
+    sync_endpoint(ZMK_ENDPOINT_USB, is_usb_ready());
+    sync_endpoint(ZMK_ENDPOINT_BLE, is_ble_ready());
+}
+#endif /* IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR) */
+
 static void update_current_endpoint() {
     enum zmk_endpoint new_endpoint = get_selected_endpoint();
 
     if (new_endpoint != current_endpoint) {
-        /* Cancel all current keypresses so keys don't stay held on the old endpoint. */
-        disconnect_current_endpoint();
+        /* Cancel all current keypresses so keys don't stay held on the old endpoint. When
+         * mirroring, the old endpoint keeps receiving reports, so there is nothing to cancel. */
+        if (!IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)) {
+            disconnect_current_endpoint();
+        }
 
         current_endpoint = new_endpoint;
         LOG_INF("Endpoint changed: %d", current_endpoint);
@@ -249,7 +377,19 @@ static void update_current_endpoint() {
 }
 
 static int endpoint_listener(const zmk_event_t *eh) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+    update_mirrored_endpoints(eh);
+#endif
     update_current_endpoint();
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY) && !IS_ENABLED(CONFIG_ZMK_ENDPOINTS_MIRROR)
+    // A host switched to may have been connected all along, without seeing the keys held now.
+    if (as_zmk_ble_active_profile_changed(eh) && current_endpoint == ZMK_ENDPOINT_BLE &&
+        is_ble_ready()) {
+        send_keyboard_report(ZMK_ENDPOINT_BLE);
+        send_consumer_report(ZMK_ENDPOINT_BLE);
+    }
+#endif
     return 0;
 }
 
@@ -10,6 +10,7 @@
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/event_manager.h>
+#include <zmk/telemetry.h>
 
 extern struct zmk_event_type *__event_type_start[];
 extern struct zmk_event_type *__event_type_end[];
@@ -20,6 +21,7 @@ extern struct zmk_event_subscription __event_subscriptions_end[];
 int zmk_event_manager_handle_from(zmk_event_t *event, uint8_t start_index) {
     int ret = 0;
     uint8_t len = __event_subscriptions_end - __event_subscriptions_start;
+    zmk_telemetry_add(ZMK_TELEMETRY_EVENTS_DISPATCHED, 1);
     for (int i = start_index; i < len; i++) {
         struct zmk_event_subscription *ev_sub = __event_subscriptions_start + i;
         if (ev_sub->event_type != event->event) {
@@ -0,0 +1,10 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <kernel.h>
+#include <zmk/events/split_central_state_changed.h>
+
+ZMK_EVENT_IMPL(zmk_split_central_state_changed);
@@ -8,19 +8,35 @@
 #include <logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <sys/math_extras.h>
+
 #include <zmk/hid.h>
 #include <dt-bindings/zmk/modifiers.h>
 
 static struct zmk_hid_keyboard_report keyboard_report = {
-    .report_id = 1, .body = {.modifiers = 0, ._reserved = 0, .keys = {0}}};
+    .report_id = ZMK_HID_REPORT_ID_KEYBOARD,
+    .body = {.modifiers = 0, ._reserved = 0, .keys = {0}}};
+
+static struct zmk_hid_consumer_report consumer_report = {.report_id = ZMK_HID_REPORT_ID_CONSUMER,
+                                                         .body = {.keys = {0}}};
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
 
-static struct zmk_hid_consumer_report consumer_report = {.report_id = 2, .body = {.keys = {0}}};
+static struct zmk_hid_mouse_report mouse_report = {
+    .report_id = ZMK_HID_REPORT_ID_MOUSE,
+    .body = {.buttons = 0, .x = 0, .y = 0, .scroll_y = 0, .scroll_x = 0}};
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
 
 // Keep track of how often a modifier was pressed.
 // Only release the modifier if the count is 0.
 static int explicit_modifier_counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 static zmk_mod_flags_t explicit_modifiers = 0;
 static zmk_mod_flags_t implicit_modifiers = 0;
+// Implicit modifiers belong to the most recently pressed usage. Only releasing that usage (as many
+// times as it was pressed) clears them, so releasing some other key doesn't drop them early.
+static uint32_t implicit_modifiers_usage = 0;
+static uint8_t implicit_modifiers_usage_count = 0;
 static zmk_mod_flags_t masked_modifiers = 0;
 
 #define SET_MODIFIERS(mods)                                                                        \
@@ -31,6 +47,41 @@ static zmk_mod_flags_t masked_modifiers = 0;
 
 #define GET_MODIFIERS (keyboard_report.body.modifiers)
 
+#define USAGE_BITMAP_WORDS(max_usage) (((max_usage) / 32) + 1)
+#define USAGE_BITMAP_SET(bitmap, usage) ((bitmap)[(usage) / 32] |= BIT((usage) % 32))
+#define USAGE_BITMAP_CLEAR(bitmap, usage) ((bitmap)[(usage) / 32] &= ~BIT((usage) % 32))
+#define USAGE_BITMAP_TEST(bitmap, usage) (((bitmap)[(usage) / 32] & BIT((usage) % 32)) != 0)
+
+// Fill an array style report with the usages set in the bitmap, zero padding unused slots.
+static inline void usage_bitmap_to_array8(const uint32_t *bitmap, size_t words, uint8_t *array,
+                                          size_t len) {
+    size_t idx = 0;
+    for (size_t word = 0; word < words && idx < len; word++) {
+        uint32_t bits = bitmap[word];
+        while (bits && idx < len) {
+            array[idx++] = (word * 32) + u32_count_trailing_zeros(bits);
+            bits &= bits - 1;
+        }
+    }
+    memset(&array[idx], 0, (len - idx) * sizeof(array[0]));
+}
+
+// The 16 bit consumer report array is not naturally aligned, so each usage is copied in.
+static inline void usage_bitmap_to_array16(const uint32_t *bitmap, size_t words, void *array,
+                                           size_t len) {
+    uint8_t *dest = array;
+    size_t idx = 0;
+    for (size_t word = 0; word < words && idx < len; word++) {
+        uint32_t bits = bitmap[word];
+        while (bits && idx < len) {
+            uint16_t usage = (word * 32) + u32_count_trailing_zeros(bits);
+            memcpy(&dest[sizeof(usage) * idx++], &usage, sizeof(usage));
+            bits &= bits - 1;
+        }
+    }
+    memset(&dest[sizeof(uint16_t) * idx], 0, (len - idx) * sizeof(uint16_t));
+}
+
 zmk_mod_flags_t zmk_hid_get_explicit_mods() { return explicit_modifiers; }
 
 int zmk_hid_register_mod(zmk_mod_t modifier) {
@@ -85,90 +136,147 @@ int zmk_hid_unregister_mods(zmk_mod_flags_t modifiers) {
 }
 
 #if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_NKRO)
+#define KEYBOARD_MAX_USAGE ZMK_HID_KEYBOARD_NKRO_MAX_USAGE
+#elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+#define KEYBOARD_MAX_USAGE ZMK_HID_KEYBOARD_HKRO_MAX_USAGE
+#else
+#error "A proper HID report type must be selected"
+#endif
 
-#define TOGGLE_KEYBOARD(code, val) WRITE_BIT(keyboard_report.body.keys[code / 8], code % 8, val)
+// The pressed keyboard usages are tracked in a bitmap so press, release and query are O(1).
+// The report sent to the host is only generated from it when the report is requested.
+static uint32_t keyboard_usages[USAGE_BITMAP_WORDS(KEYBOARD_MAX_USAGE)];
+static uint8_t keyboard_usages_count = 0;
+static bool keyboard_report_dirty = false;
 
 static inline int select_keyboard_usage(zmk_key_t usage) {
-    if (usage > ZMK_HID_KEYBOARD_NKRO_MAX_USAGE) {
+    if (usage == 0U || usage > KEYBOARD_MAX_USAGE) {
         return -EINVAL;
     }
-    TOGGLE_KEYBOARD(usage, 1);
+    if (USAGE_BITMAP_TEST(keyboard_usages, usage)) {
+        return 0;
+    }
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+    if (keyboard_usages_count >= CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE) {
+        LOG_DBG("No free slot in keyboard report for usage 0x%02X", usage);
+        return 0;
+    }
+#endif
+    USAGE_BITMAP_SET(keyboard_usages, usage);
+    keyboard_usages_count++;
+    keyboard_report_dirty = true;
     return 0;
 }
 
 static inline int deselect_keyboard_usage(zmk_key_t usage) {
-    if (usage > ZMK_HID_KEYBOARD_NKRO_MAX_USAGE) {
+    if (usage == 0U || usage > KEYBOARD_MAX_USAGE) {
         return -EINVAL;
     }
-    TOGGLE_KEYBOARD(usage, 0);
+    if (!USAGE_BITMAP_TEST(keyboard_usages, usage)) {
+        return 0;
+    }
+    USAGE_BITMAP_CLEAR(keyboard_usages, usage);
+    keyboard_usages_count--;
+    keyboard_report_dirty = true;
     return 0;
 }
 
 static inline bool check_keyboard_usage(zmk_key_t usage) {
-    if (usage > ZMK_HID_KEYBOARD_NKRO_MAX_USAGE) {
+    if (usage > KEYBOARD_MAX_USAGE) {
         return false;
     }
-    return keyboard_report.body.keys[usage / 8] & (1 << (usage % 8));
+    return USAGE_BITMAP_TEST(keyboard_usages, usage);
 }
 
-#elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+static void serialize_keyboard_usages() {
+    if (!keyboard_report_dirty) {
+        return;
+    }
 
-#define TOGGLE_KEYBOARD(match, val)                                                                \
-    for (int idx = 0; idx < CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE; idx++) {                          \
-        if (keyboard_report.body.keys[idx] != match) {                                             \
-            continue;                                                                              \
-        }                                                                                          \
-        keyboard_report.body.keys[idx] = val;                                                      \
-        if (val) {                                                                                 \
-            break;                                                                                 \
-        }                                                                                          \
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_NKRO)
+    for (int i = 0; i < sizeof(keyboard_report.body.keys); i++) {
+        keyboard_report.body.keys[i] = keyboard_usages[i / 4] >> ((i % 4) * 8);
     }
+#elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+    usage_bitmap_to_array8(keyboard_usages, ARRAY_SIZE(keyboard_usages), keyboard_report.body.keys,
+                           CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE);
+#endif
+    keyboard_report_dirty = false;
+}
 
-static inline int select_keyboard_usage(zmk_key_t usage) {
-    TOGGLE_KEYBOARD(0U, usage);
+#if IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_BASIC)
+#define ZMK_HID_CONSUMER_MAX_USAGE 0xFF
+#elif IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_FULL)
+#define ZMK_HID_CONSUMER_MAX_USAGE 0xFFF
+#endif
+
+// Consumer usages get the same treatment as the keyboard report: a bitmap holds the pressed
+// state and the report array is only generated from it on demand.
+static uint32_t consumer_usages[USAGE_BITMAP_WORDS(ZMK_HID_CONSUMER_MAX_USAGE)];
+static uint8_t consumer_usages_count = 0;
+static bool consumer_report_dirty = false;
+
+static inline int select_consumer_usage(zmk_key_t usage) {
+    if (usage > ZMK_HID_CONSUMER_MAX_USAGE) {
+        return -ENOTSUP;
+    }
+    if (usage == 0U || USAGE_BITMAP_TEST(consumer_usages, usage)) {
+        return 0;
+    }
+    if (consumer_usages_count >= CONFIG_ZMK_HID_CONSUMER_REPORT_SIZE) {
+        LOG_DBG("No free slot in consumer report for usage 0x%02X", usage);
+        return 0;
+    }
+    USAGE_BITMAP_SET(consumer_usages, usage);
+    consumer_usages_count++;
+    consumer_report_dirty = true;
     return 0;
 }
 
-static inline int deselect_keyboard_usage(zmk_key_t usage) {
-    TOGGLE_KEYBOARD(usage, 0U);
+static inline int deselect_consumer_usage(zmk_key_t usage) {
+    if (usage == 0U || usage > ZMK_HID_CONSUMER_MAX_USAGE ||
+        !USAGE_BITMAP_TEST(consumer_usages, usage)) {
+        return 0;
+    }
+    USAGE_BITMAP_CLEAR(consumer_usages, usage);
+    consumer_usages_count--;
+    consumer_report_dirty = true;
     return 0;
 }
 
-static inline int check_keyboard_usage(zmk_key_t usage) {
-    for (int idx = 0; idx < CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE; idx++) {
-        if (keyboard_report.body.keys[idx] == usage) {
-            return true;
-        }
+static void serialize_consumer_usages() {
+    if (!consumer_report_dirty) {
+        return;
     }
-    return false;
-}
 
-#else
-#error "A proper HID report type must be selected"
+#if IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_BASIC)
+    usage_bitmap_to_array8(consumer_usages, ARRAY_SIZE(consumer_usages), consumer_report.body.keys,
+                           CONFIG_ZMK_HID_CONSUMER_REPORT_SIZE);
+#elif IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_FULL)
+    usage_bitmap_to_array16(consumer_usages, ARRAY_SIZE(consumer_usages), consumer_report.body.keys,
+                            CONFIG_ZMK_HID_CONSUMER_REPORT_SIZE);
 #endif
+    consumer_report_dirty = false;
+}
 
-#define TOGGLE_CONSUMER(match, val)                                                                \
-    COND_CODE_1(IS_ENABLED(CONFIG_ZMK_HID_CONSUMER_REPORT_USAGES_BASIC),                           \
-                (if (val > 0xFF) { return -ENOTSUP; }), ())                                        \
-    for (int idx = 0; idx < CONFIG_ZMK_HID_CONSUMER_REPORT_SIZE; idx++) {                          \
-        if (consumer_report.body.keys[idx] != match) {                                             \
-            continue;                                                                              \
-        }                                                                                          \
-        consumer_report.body.keys[idx] = val;                                                      \
-        if (val) {                                                                                 \
-            break;                                                                                 \
-        }                                                                                          \
+int zmk_hid_implicit_modifiers_press(uint32_t usage, zmk_mod_flags_t new_implicit_modifiers) {
+    if (usage == implicit_modifiers_usage && implicit_modifiers_usage_count > 0) {
+        implicit_modifiers_usage_count++;
+    } else {
+        implicit_modifiers_usage = usage;
+        implicit_modifiers_usage_count = 1;
     }
-
-int zmk_hid_implicit_modifiers_press(zmk_mod_flags_t new_implicit_modifiers) {
     implicit_modifiers = new_implicit_modifiers;
     zmk_mod_flags_t current = GET_MODIFIERS;
     SET_MODIFIERS(explicit_modifiers);
     return current == GET_MODIFIERS ? 0 : 1;
 }
 
-int zmk_hid_implicit_modifiers_release() {
-    implicit_modifiers = 0;
+int zmk_hid_implicit_modifiers_release(uint32_t usage) {
+    if (usage == implicit_modifiers_usage && implicit_modifiers_usage_count > 0 &&
+        --implicit_modifiers_usage_count == 0) {
+        implicit_modifiers = 0;
+    }
     zmk_mod_flags_t current = GET_MODIFIERS;
     SET_MODIFIERS(explicit_modifiers);
     return current == GET_MODIFIERS ? 0 : 1;
@@ -211,27 +319,29 @@ bool zmk_hid_keyboard_is_pressed(zmk_key_t code) {
     return check_keyboard_usage(code);
 }
 
-void zmk_hid_keyboard_clear() { memset(&keyboard_report.body, 0, sizeof(keyboard_report.body)); }
+void zmk_hid_keyboard_clear() {
+    memset(keyboard_usages, 0, sizeof(keyboard_usages));
+    keyboard_usages_count = 0;
+    keyboard_report_dirty = false;
+    memset(&keyboard_report.body, 0, sizeof(keyboard_report.body));
+}
 
-int zmk_hid_consumer_press(zmk_key_t code) {
-    TOGGLE_CONSUMER(0U, code);
-    return 0;
-};
+int zmk_hid_consumer_press(zmk_key_t code) { return select_consumer_usage(code); };
 
-int zmk_hid_consumer_release(zmk_key_t code) {
-    TOGGLE_CONSUMER(code, 0U);
-    return 0;
-};
+int zmk_hid_consumer_release(zmk_key_t code) { return deselect_consumer_usage(code); };
 
-void zmk_hid_consumer_clear() { memset(&consumer_report.body, 0, sizeof(consumer_report.body)); }
+void zmk_hid_consumer_clear() {
+    memset(consumer_usages, 0, sizeof(consumer_usages));
+    consumer_usages_count = 0;
+    consumer_report_dirty = false;
+    memset(&consumer_report.body, 0, sizeof(consumer_report.body));
+}
 
 bool zmk_hid_consumer_is_pressed(zmk_key_t key) {
-    for (int idx = 0; idx < CONFIG_ZMK_HID_CONSUMER_REPORT_SIZE; idx++) {
-        if (consumer_report.body.keys[idx] == key) {
-            return true;
-        }
+    if (key > ZMK_HID_CONSUMER_MAX_USAGE) {
+        return false;
     }
-    return false;
+    return USAGE_BITMAP_TEST(consumer_usages, key);
 }
 
 int zmk_hid_press(uint32_t usage) {
@@ -264,10 +374,194 @@ bool zmk_hid_is_pressed(uint32_t usage) {
     return false;
 }
 
+#define USAGE_ARRAY_IS_SUBSET(array, other)                                                        \
+    ({                                                                                             \
+        bool is_subset = true;                                                                     \
+        for (int i = 0; i < ARRAY_SIZE(array) && is_subset; i++) {                                 \
+            bool found = (array)[i] == 0;                                                          \
+            for (int j = 0; j < ARRAY_SIZE(other) && !found; j++) {                                \
+                found = (other)[j] == (array)[i];                                                  \
+            }                                                                                      \
+            is_subset = found;                                                                     \
+        }                                                                                          \
+        is_subset;                                                                                 \
+    })
+
+bool zmk_hid_keyboard_report_is_subset(const struct zmk_hid_keyboard_report_body *report,
+                                       const struct zmk_hid_keyboard_report_body *other) {
+    if (report->modifiers & ~other->modifiers) {
+        return false;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_NKRO)
+    for (int i = 0; i < ARRAY_SIZE(report->keys); i++) {
+        if (report->keys[i] & ~other->keys[i]) {
+            return false;
+        }
+    }
+    return true;
+#elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+    return USAGE_ARRAY_IS_SUBSET(report->keys, other->keys);
+#endif
+}
+
+bool zmk_hid_consumer_report_is_subset(const struct zmk_hid_consumer_report_body *report,
+                                       const struct zmk_hid_consumer_report_body *other) {
+    return USAGE_ARRAY_IS_SUBSET(report->keys, other->keys);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+// Keep track of how often a button was pressed.
+// Only release the button if the count is 0.
+static int explicit_button_counts[ZMK_HID_MOUSE_NUM_BUTTONS] = {0};
+static bool mouse_buttons_dirty = false;
+
+// Movement and scroll deltas that have not been sent to the host yet. Everything reported between
+// two transmissions is merged here, and anything that doesn't fit in one report is carried over.
+static int32_t pending_x = 0;
+static int32_t pending_y = 0;
+static int32_t pending_scroll_x = 0;
+static int32_t pending_scroll_y = 0;
+
+#define MOUSE_REPORT_DELTA_MIN (INT16_MIN + 1)
+#define MOUSE_REPORT_DELTA_MAX INT16_MAX
+
+int zmk_hid_mouse_button_press(zmk_mouse_button_t button) {
+    if (button >= ZMK_HID_MOUSE_NUM_BUTTONS) {
+        return -EINVAL;
+    }
+
+    explicit_button_counts[button]++;
+    LOG_DBG("Button %d count %d", button, explicit_button_counts[button]);
+    if (!(mouse_report.body.buttons & BIT(button))) {
+        WRITE_BIT(mouse_report.body.buttons, button, true);
+        mouse_buttons_dirty = true;
+    }
+    return 0;
+}
+
+int zmk_hid_mouse_button_release(zmk_mouse_button_t button) {
+    if (button >= ZMK_HID_MOUSE_NUM_BUTTONS) {
+        return -EINVAL;
+    }
+
+    if (explicit_button_counts[button] <= 0) {
+        LOG_ERR("Tried to release button %d too often", button);
+        return -EINVAL;
+    }
+    explicit_button_counts[button]--;
+    LOG_DBG("Button %d count: %d", button, explicit_button_counts[button]);
+    if (explicit_button_counts[button] == 0) {
+        LOG_DBG("Button %d released", button);
+        WRITE_BIT(mouse_report.body.buttons, button, false);
+        mouse_buttons_dirty = true;
+    }
+    return 0;
+}
+
+int zmk_hid_mouse_buttons_press(zmk_mouse_button_flags_t buttons) {
+    for (zmk_mouse_button_t i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+        if (buttons & BIT(i)) {
+            zmk_hid_mouse_button_press(i);
+        }
+    }
+    return 0;
+}
+
+int zmk_hid_mouse_buttons_release(zmk_mouse_button_flags_t buttons) {
+    for (zmk_mouse_button_t i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+        if (buttons & BIT(i)) {
+            zmk_hid_mouse_button_release(i);
+        }
+    }
+    return 0;
+}
+
+void zmk_hid_mouse_movement_add(int32_t x, int32_t y) {
+    pending_x += x;
+    pending_y += y;
+}
+
+void zmk_hid_mouse_scroll_add(int32_t x, int32_t y) {
+    pending_scroll_x += x;
+    pending_scroll_y += y;
+}
+
+bool zmk_hid_mouse_has_pending() {
+    return mouse_buttons_dirty || pending_x != 0 || pending_y != 0 || pending_scroll_x != 0 ||
+           pending_scroll_y != 0;
+}
+
+static inline int16_t take_pending_delta(int32_t *pending) {
+    int16_t delta = CLAMP(*pending, MOUSE_REPORT_DELTA_MIN, MOUSE_REPORT_DELTA_MAX);
+    *pending -= delta;
+    return delta;
+}
+
+bool zmk_hid_mouse_prepare_report() {
+    if (!zmk_hid_mouse_has_pending()) {
+        return false;
+    }
+
+    mouse_report.body.x = take_pending_delta(&pending_x);
+    mouse_report.body.y = take_pending_delta(&pending_y);
+    mouse_report.body.scroll_x = take_pending_delta(&pending_scroll_x);
+    mouse_report.body.scroll_y = take_pending_delta(&pending_scroll_y);
+    mouse_buttons_dirty = false;
+
+    LOG_DBG("Mouse report buttons 0x%02X x %d y %d scroll %d/%d", mouse_report.body.buttons,
+            mouse_report.body.x, mouse_report.body.y, mouse_report.body.scroll_x,
+            mouse_report.body.scroll_y);
+    return true;
+}
+
+void zmk_hid_mouse_clear() {
+    pending_x = pending_y = pending_scroll_x = pending_scroll_y = 0;
+    mouse_buttons_dirty = false;
+    memset(&mouse_report.body, 0, sizeof(mouse_report.body));
+}
+
+static inline bool delta_fits(int32_t delta) {
+    return delta >= MOUSE_REPORT_DELTA_MIN && delta <= MOUSE_REPORT_DELTA_MAX;
+}
+
+bool zmk_hid_mouse_report_merge(struct zmk_hid_mouse_report_body *report,
+                                const struct zmk_hid_mouse_report_body *next) {
+    // The report is packed, so its fields are summed by value rather than through pointers.
+    int32_t x = report->x + next->x;
+    int32_t y = report->y + next->y;
+    int32_t scroll_x = report->scroll_x + next->scroll_x;
+    int32_t scroll_y = report->scroll_y + next->scroll_y;
+
+    if (!delta_fits(x) || !delta_fits(y) || !delta_fits(scroll_x) || !delta_fits(scroll_y)) {
+        return false;
+    }
+
+    report->buttons = next->buttons;
+    report->x = x;
+    report->y = y;
+    report->scroll_x = scroll_x;
+    report->scroll_y = scroll_y;
+    return true;
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
 struct zmk_hid_keyboard_report *zmk_hid_get_keyboard_report() {
+    serialize_keyboard_usages();
     return &keyboard_report;
 }
 
 struct zmk_hid_consumer_report *zmk_hid_get_consumer_report() {
+    serialize_consumer_usages();
     return &consumer_report;
 }
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+struct zmk_hid_mouse_report *zmk_hid_get_mouse_report() {
+    return &mouse_report;
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
@@ -15,6 +15,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/hid.h>
 #include <dt-bindings/zmk/hid_usage_pages.h>
 #include <zmk/endpoints.h>
+#include <zmk/latency.h>
 
 static int hid_listener_keycode_pressed(const struct zmk_keycode_state_changed *ev) {
     int err, explicit_mods_changed, implicit_mods_changed;
@@ -27,7 +28,8 @@ static int hid_listener_keycode_pressed(const struct zmk_keycode_state_changed *
         return err;
     }
     explicit_mods_changed = zmk_hid_register_mods(ev->explicit_modifiers);
-    implicit_mods_changed = zmk_hid_implicit_modifiers_press(ev->implicit_modifiers);
+    implicit_mods_changed = zmk_hid_implicit_modifiers_press(
+        ZMK_HID_USAGE(ev->usage_page, ev->keycode), ev->implicit_modifiers);
     if (ev->usage_page != HID_USAGE_KEY &&
         (explicit_mods_changed > 0 || implicit_mods_changed > 0)) {
         err = zmk_endpoints_send_report(HID_USAGE_KEY);
@@ -52,13 +54,10 @@ static int hid_listener_keycode_released(const struct zmk_keycode_state_changed
     }
 
     explicit_mods_changed = zmk_hid_unregister_mods(ev->explicit_modifiers);
-    // There is a minor issue with this code.
-    // If LC(A) is pressed, then LS(B), then LC(A) is released, the shift for B will be released
-    // prematurely. This causes if LS(B) to repeat like Bbbbbbbb when pressed for a long time.
-    // Solving this would require keeping track of which key's implicit modifiers are currently
-    // active and only releasing modifiers at that time.
-    implicit_mods_changed = zmk_hid_implicit_modifiers_release();
-    ;
+    // Only releases the implicit modifiers if this keycode is the one that set them, so releasing
+    // LC(A) while LS(B) is held doesn't turn the held B into "Bbbbbbbb".
+    implicit_mods_changed =
+        zmk_hid_implicit_modifiers_release(ZMK_HID_USAGE(ev->usage_page, ev->keycode));
     if (ev->usage_page != HID_USAGE_KEY &&
         (explicit_mods_changed > 0 || implicit_mods_changed > 0)) {
         err = zmk_endpoints_send_report(HID_USAGE_KEY);
@@ -73,6 +72,9 @@ static int hid_listener_keycode_released(const struct zmk_keycode_state_changed
 int hid_listener(const zmk_event_t *eh) {
     const struct zmk_keycode_state_changed *ev = as_zmk_keycode_state_changed(eh);
     if (ev) {
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+        zmk_latency_keycode_changed(ev->usage_page, ev->timestamp);
+#endif
         if (ev->state) {
             hid_listener_keycode_pressed(ev);
         } else {
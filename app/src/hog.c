@@ -17,6 +17,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/ble.h>
 #include <zmk/hog.h>
 #include <zmk/hid.h>
+#include <zmk/latency.h>
+#include <zmk/telemetry.h>
 
 enum {
     HIDS_REMOTE_WAKE = BIT(0),
@@ -47,15 +49,33 @@ enum {
 };
 
 static struct hids_report input = {
-    .id = 0x01,
+    .id = ZMK_HID_REPORT_ID_KEYBOARD,
     .type = HIDS_INPUT,
 };
 
 static struct hids_report consumer_input = {
-    .id = 0x02,
+    .id = ZMK_HID_REPORT_ID_CONSUMER,
     .type = HIDS_INPUT,
 };
 
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+static struct hids_report mouse_input = {
+    .id = ZMK_HID_REPORT_ID_MOUSE,
+    .type = HIDS_INPUT,
+};
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+static struct hids_report telemetry_input = {
+    .id = ZMK_HID_REPORT_ID_TELEMETRY,
+    .type = HIDS_INPUT,
+};
+
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
 static bool host_requests_notification = false;
 static uint8_t ctrl_point;
 // static uint8_t proto_mode;
@@ -93,6 +113,29 @@ static ssize_t read_hids_consumer_input_report(struct bt_conn *conn,
                              sizeof(struct zmk_hid_consumer_report_body));
 }
 
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+static ssize_t read_hids_mouse_input_report(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                            void *buf, uint16_t len, uint16_t offset) {
+    struct zmk_hid_mouse_report_body *report_body = &zmk_hid_get_mouse_report()->body;
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, report_body,
+                             sizeof(struct zmk_hid_mouse_report_body));
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+static ssize_t read_hids_telemetry_input_report(struct bt_conn *conn,
+                                                const struct bt_gatt_attr *attr, void *buf,
+                                                uint16_t len, uint16_t offset) {
+    // Frames only mean something as part of the stream, so reads get an empty one.
+    struct zmk_hid_telemetry_report_body report_body = {0};
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &report_body, sizeof(report_body));
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
 // static ssize_t write_proto_mode(struct bt_conn *conn,
 //                                 const struct bt_gatt_attr *attr,
 //                                 const void *buf, uint16_t len, uint16_t offset,
@@ -139,19 +182,34 @@ BT_GATT_SERVICE_DEFINE(
     BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
     BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
                        NULL, &consumer_input),
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_READ_ENCRYPT, read_hids_mouse_input_report, NULL, NULL),
+    BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
+                       NULL, &mouse_input),
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_READ_ENCRYPT, read_hids_telemetry_input_report, NULL,
+                           NULL),
+    BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
+                       NULL, &telemetry_input),
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
     BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_CTRL_POINT, BT_GATT_CHRC_WRITE_WITHOUT_RESP,
                            BT_GATT_PERM_WRITE, NULL, write_ctrl_point, &ctrl_point));
 
+// The telemetry report characteristic comes right after the mouse one, if there is one.
+#define HOG_TELEMETRY_ATTR (IS_ENABLED(CONFIG_ZMK_MOUSE) ? 17 : 13)
+
 struct bt_conn *destination_connection() {
-    struct bt_conn *conn;
-    bt_addr_le_t *addr = zmk_ble_active_profile_addr();
-    LOG_DBG("Address pointer %p", addr);
-    if (!bt_addr_le_cmp(addr, BT_ADDR_LE_ANY)) {
-        LOG_WRN("Not sending, no active address for current profile");
-        return NULL;
-    } else if ((conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr)) == NULL) {
+    struct bt_conn *conn = zmk_ble_active_profile_conn();
+    if (conn == NULL) {
         LOG_WRN("Not sending, not connected to active profile");
-        return NULL;
     }
 
     return conn;
@@ -161,105 +219,508 @@ K_THREAD_STACK_DEFINE(hog_q_stack, CONFIG_ZMK_BLE_THREAD_STACK_SIZE);
 
 struct k_work_q hog_work_q;
 
-K_MSGQ_DEFINE(zmk_hog_keyboard_msgq, sizeof(struct zmk_hid_keyboard_report_body),
-              CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE, 4);
+BUILD_ASSERT(CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE >= 2,
+             "The keyboard report queue needs room for at least two states");
+BUILD_ASSERT(CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE >= 2,
+             "The consumer report queue needs room for at least two states");
+
+// If notifying fails because the stack is out of buffers, the link is congested: keep everything
+// pending and try again a little later.
+#define SEND_RETRY_DELAY K_MSEC(10)
+
+// Keyboard and consumer reports are queued as pending states, oldest first. Every state is a
+// complete report, so the newest one always leaves the host in the right state; the ones before it
+// only matter for the transitions they carry. When a queue is full, a state whose neighbours make
+// it redundant is merged away. If none is, the new state waits in the overflow slot until a state
+// has been sent. The newest state is never dropped, so keys can't get stuck on the host.
+struct hog_state_queue {
+    uint8_t *states;
+    size_t state_size;
+    // The newest keycode change each state carries, for the latency probe
+    uint32_t *keycode_sequences;
+    uint8_t capacity;
+    uint8_t count;
+    uint8_t *overflow;
+    uint32_t overflow_keycode_sequence;
+    bool has_overflow;
+    bool (*is_subset)(const void *state, const void *other);
+};
 
-void send_keyboard_report_callback(struct k_work *work) {
-    struct zmk_hid_keyboard_report_body report;
+static bool keyboard_state_is_subset(const void *state, const void *other) {
+    return zmk_hid_keyboard_report_is_subset(state, other);
+}
 
-    while (k_msgq_get(&zmk_hog_keyboard_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection();
-        if (conn == NULL) {
-            return;
-        }
+static bool consumer_state_is_subset(const void *state, const void *other) {
+    return zmk_hid_consumer_report_is_subset(state, other);
+}
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc.attrs[5],
-            .data = &report,
-            .len = sizeof(report),
-        };
+static uint8_t keyboard_states[CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE]
+                              [sizeof(struct zmk_hid_keyboard_report_body)];
+static uint8_t consumer_states[CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE]
+                              [sizeof(struct zmk_hid_consumer_report_body)];
+static uint8_t keyboard_overflow[sizeof(struct zmk_hid_keyboard_report_body)];
+static uint8_t consumer_overflow[sizeof(struct zmk_hid_consumer_report_body)];
+static uint32_t keyboard_keycode_sequences[CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE];
+static uint32_t consumer_keycode_sequences[CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE];
+
+static struct hog_state_queue keyboard_queue = {
+    .states = (uint8_t *)keyboard_states,
+    .state_size = sizeof(struct zmk_hid_keyboard_report_body),
+    .keycode_sequences = keyboard_keycode_sequences,
+    .capacity = CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE,
+    .overflow = keyboard_overflow,
+    .is_subset = keyboard_state_is_subset,
+};
 
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err) {
-            LOG_ERR("Error notifying %d", err);
+static struct hog_state_queue consumer_queue = {
+    .states = (uint8_t *)consumer_states,
+    .state_size = sizeof(struct zmk_hid_consumer_report_body),
+    .keycode_sequences = consumer_keycode_sequences,
+    .capacity = CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE,
+    .overflow = consumer_overflow,
+    .is_subset = consumer_state_is_subset,
+};
+
+static struct k_spinlock state_queue_lock;
+
+static void *queued_state(struct hog_state_queue *queue, uint8_t index) {
+    return queue->states + index * queue->state_size;
+}
+
+static void remove_state(struct hog_state_queue *queue, uint8_t index) {
+    memmove(queued_state(queue, index), queued_state(queue, index + 1),
+            (queue->count - index - 1) * queue->state_size);
+    memmove(&queue->keycode_sequences[index], &queue->keycode_sequences[index + 1],
+            (queue->count - index - 1) * sizeof(queue->keycode_sequences[0]));
+    queue->count--;
+}
+
+// A state is redundant if it lies between its neighbours, e.g. another key was pressed on the way
+// to it and one more after it. Dropping it batches those presses into one report, but doesn't hide
+// any transition.
+static bool state_is_redundant(const struct hog_state_queue *queue, const void *prev,
+                               const void *state, const void *next) {
+    return (queue->is_subset(prev, state) && queue->is_subset(state, next)) ||
+           (queue->is_subset(next, state) && queue->is_subset(state, prev));
+}
+
+static bool is_newest_state(struct hog_state_queue *queue, const void *state) {
+    return queue->count > 0 &&
+           memcmp(queued_state(queue, queue->count - 1), state, queue->state_size) == 0;
+}
+
+static void append_state(struct hog_state_queue *queue, const void *state,
+                         uint32_t keycode_sequence) {
+    if (is_newest_state(queue, state)) {
+        // The keycode changes since then led back to the same state, which is still to be sent.
+        queue->keycode_sequences[queue->count - 1] = keycode_sequence;
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+        return;
+    }
+
+    queue->keycode_sequences[queue->count] = keycode_sequence;
+    memcpy(queued_state(queue, queue->count++), state, queue->state_size);
+    zmk_telemetry_queue_used(ZMK_TELEMETRY_QUEUE_HOG, queue->count);
+}
+
+// Returns false if the queue is full and every pending state carries a transition.
+static bool push_state(struct hog_state_queue *queue, const void *state,
+                       uint32_t keycode_sequence) {
+    if (queue->count == queue->capacity && !is_newest_state(queue, state)) {
+        // The first state may be in the middle of being sent, so it's never merged away. The new
+        // state is the newest one's next neighbour.
+        int merged = -1;
+        for (int i = queue->count - 1; i >= 1; i--) {
+            const void *next = i + 1 < queue->count ? queued_state(queue, i + 1) : state;
+            if (state_is_redundant(queue, queued_state(queue, i - 1), queued_state(queue, i),
+                                   next)) {
+                merged = i;
+                break;
+            }
         }
 
-        bt_conn_unref(conn);
+        if (merged < 0) {
+            return false;
+        }
+
+        LOG_DBG("Report queue full, merging pending state %d", merged);
+        remove_state(queue, merged);
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
     }
+
+    append_state(queue, state, keycode_sequence);
+    return true;
 }
 
-K_WORK_DEFINE(hog_keyboard_work, send_keyboard_report_callback);
+// Only the newest state waits for room, so a newer one takes its place. Nothing is lost if the
+// waiting state lies between the newest queued state and the new one.
+static void replace_overflow_state(struct hog_state_queue *queue, const void *state,
+                                   uint32_t keycode_sequence) {
+    queue->overflow_keycode_sequence = keycode_sequence;
 
-int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *report) {
-    int err = k_msgq_put(&zmk_hog_keyboard_msgq, report, K_MSEC(100));
-    if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Keyboard message queue full, popping first message and queueing again");
-            struct zmk_hid_keyboard_report_body discarded_report;
-            k_msgq_get(&zmk_hog_keyboard_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_keyboard_report(report);
+    if (memcmp(queue->overflow, state, queue->state_size) == 0) {
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+        return;
+    }
+
+    if (state_is_redundant(queue, queued_state(queue, queue->count - 1), queue->overflow, state)) {
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+    } else {
+        LOG_WRN("Report queue full, replacing a pending state the host hasn't seen");
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, 1);
+    }
+
+    memcpy(queue->overflow, state, queue->state_size);
+}
+
+static void remove_sent_state(struct hog_state_queue *queue) {
+    remove_state(queue, 0);
+
+    if (queue->has_overflow) {
+        queue->has_overflow = false;
+        append_state(queue, queue->overflow, queue->overflow_keycode_sequence);
+    }
+}
+
+static void send_reports_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(hog_send_work, send_reports_callback);
+
+static void send_reports_callback(struct k_work *work) {
+    struct bt_conn *conn = destination_connection();
+    if (conn == NULL) {
+        k_spinlock_key_t key = k_spin_lock(&state_queue_lock);
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED,
+                          keyboard_queue.count + keyboard_queue.has_overflow +
+                              consumer_queue.count + consumer_queue.has_overflow);
+        keyboard_queue.count = 0;
+        keyboard_queue.has_overflow = false;
+        consumer_queue.count = 0;
+        consumer_queue.has_overflow = false;
+        k_spin_unlock(&state_queue_lock, key);
+        return;
+    }
+
+    while (true) {
+        struct zmk_hid_keyboard_report_body keyboard_report;
+        struct zmk_hid_consumer_report_body consumer_report;
+        struct bt_gatt_notify_params params[2];
+        uint16_t num_params = 0;
+
+        k_spinlock_key_t key = k_spin_lock(&state_queue_lock);
+        bool send_keyboard = keyboard_queue.count > 0;
+        bool send_consumer = consumer_queue.count > 0;
+        if (send_keyboard) {
+            memcpy(&keyboard_report, queued_state(&keyboard_queue, 0), sizeof(keyboard_report));
+        }
+        if (send_consumer) {
+            memcpy(&consumer_report, queued_state(&consumer_queue, 0), sizeof(consumer_report));
+        }
+        k_spin_unlock(&state_queue_lock, key);
+
+        if (send_keyboard) {
+            params[num_params++] = (struct bt_gatt_notify_params){
+                .attr = &hog_svc.attrs[5],
+                .data = &keyboard_report,
+                .len = sizeof(keyboard_report),
+            };
+        }
+        if (send_consumer) {
+            params[num_params++] = (struct bt_gatt_notify_params){
+                .attr = &hog_svc.attrs[10],
+                .data = &consumer_report,
+                .len = sizeof(consumer_report),
+            };
+        }
+        if (num_params == 0) {
+            break;
+        }
+
+        // Both reports go out together, in one PDU with CONFIG_BT_GATT_NOTIFY_MULTIPLE or back to
+        // back in the same connection event otherwise.
+        int err = bt_gatt_notify_multiple(conn, num_params, params);
+        if (err == -ENOMEM) {
+            // Sending a state again is harmless if part of the batch did make it out.
+            k_work_schedule_for_queue(&hog_work_q, &hog_send_work, SEND_RETRY_DELAY);
+            break;
+        } else if (err) {
+            LOG_ERR("Error notifying %d", err);
+        }
+
+        if (!err) {
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SENT, num_params);
+        }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_FAST_RECONNECT)
+        if (!err) {
+            zmk_ble_reconnect_report_sent();
+        }
+#endif
+
+        key = k_spin_lock(&state_queue_lock);
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+        // Only this work removes states, so the ones just sent are still first.
+        if (!err && send_keyboard) {
+            zmk_latency_report_sent(HID_USAGE_KEY, keyboard_queue.keycode_sequences[0]);
+        }
+        if (!err && send_consumer) {
+            zmk_latency_report_sent(HID_USAGE_CONSUMER, consumer_queue.keycode_sequences[0]);
+        }
+#endif
+        if (send_keyboard) {
+            remove_sent_state(&keyboard_queue);
         }
-        default:
-            LOG_WRN("Failed to queue keyboard report to send (%d)", err);
-            return err;
+        if (send_consumer) {
+            remove_sent_state(&consumer_queue);
         }
+        k_spin_unlock(&state_queue_lock, key);
     }
 
-    k_work_submit_to_queue(&hog_work_q, &hog_keyboard_work);
+    bt_conn_unref(conn);
+}
+
+static void queue_state(struct hog_state_queue *queue, const void *state) {
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    uint32_t keycode_sequence = zmk_latency_keycode_sequence();
+#else
+    uint32_t keycode_sequence = 0;
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&state_queue_lock);
+    if (queue->has_overflow) {
+        replace_overflow_state(queue, state, keycode_sequence);
+    } else if (!push_state(queue, state, keycode_sequence)) {
+        // Every pending state carries a transition the host must see, so this one waits for the
+        // next to be sent rather than holding up the caller.
+        memcpy(queue->overflow, state, queue->state_size);
+        queue->overflow_keycode_sequence = keycode_sequence;
+        queue->has_overflow = true;
+    }
+    k_spin_unlock(&state_queue_lock, key);
+
+    k_work_schedule_for_queue(&hog_work_q, &hog_send_work, K_NO_WAIT);
+}
 
+int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *report) {
+    queue_state(&keyboard_queue, report);
+    return 0;
+};
+
+int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *report) {
+    queue_state(&consumer_queue, report);
     return 0;
 };
 
-K_MSGQ_DEFINE(zmk_hog_consumer_msgq, sizeof(struct zmk_hid_consumer_report_body),
-              CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE, 4);
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
 
-void send_consumer_report_callback(struct k_work *work) {
-    struct zmk_hid_consumer_report_body report;
+BUILD_ASSERT(CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE >= 2,
+             "The mouse report queue needs room for at least two reports");
 
-    while (k_msgq_get(&zmk_hog_consumer_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection();
-        if (conn == NULL) {
+// Mouse reports are queued oldest first, like the keyboard states. Their movement is relative, so
+// when the queue is full a report is merged into its neighbour rather than dropped: the movement
+// adds up, and only reports with the same buttons are merged so clicks survive too.
+static struct zmk_hid_mouse_report_body mouse_reports[CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE];
+static uint8_t mouse_report_count;
+static struct k_spinlock mouse_queue_lock;
+
+static void remove_mouse_report(uint8_t index) {
+    memmove(&mouse_reports[index], &mouse_reports[index + 1],
+            (mouse_report_count - index - 1) * sizeof(mouse_reports[0]));
+    mouse_report_count--;
+}
+
+static bool merge_mouse_reports(struct zmk_hid_mouse_report_body *report,
+                                const struct zmk_hid_mouse_report_body *next) {
+    return report->buttons == next->buttons && zmk_hid_mouse_report_merge(report, next);
+}
+
+static void push_mouse_report(const struct zmk_hid_mouse_report_body *report) {
+    if (mouse_report_count == CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE) {
+        // As with the keyboard states, the first report may be in the middle of being sent.
+        uint8_t newest = mouse_report_count - 1;
+        if (merge_mouse_reports(&mouse_reports[newest], report)) {
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+            return;
+        }
+
+        for (uint8_t i = 1; i < newest; i++) {
+            if (merge_mouse_reports(&mouse_reports[i], &mouse_reports[i + 1])) {
+                remove_mouse_report(i + 1);
+                zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+                break;
+            }
+        }
+
+        if (mouse_report_count == CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE) {
+            // Every queued report changes the buttons. The movement still adds up, and the host
+            // ends up with the latest buttons, but it misses a click.
+            LOG_WRN("Mouse report queue full of button changes, merging the newest two");
+            if (!zmk_hid_mouse_report_merge(&mouse_reports[newest], report)) {
+                mouse_reports[newest] = *report;
+            }
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, 1);
             return;
         }
+    }
+
+    mouse_reports[mouse_report_count++] = *report;
+    zmk_telemetry_queue_used(ZMK_TELEMETRY_QUEUE_HOG, mouse_report_count);
+}
+
+static void send_mouse_report_callback(struct k_work *work) {
+    struct zmk_hid_mouse_report_body report;
+
+    struct bt_conn *conn = destination_connection();
+    if (conn == NULL) {
+        k_spinlock_key_t key = k_spin_lock(&mouse_queue_lock);
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, mouse_report_count);
+        mouse_report_count = 0;
+        k_spin_unlock(&mouse_queue_lock, key);
+        return;
+    }
+
+    while (true) {
+        k_spinlock_key_t key = k_spin_lock(&mouse_queue_lock);
+        bool pending = mouse_report_count > 0;
+        if (pending) {
+            report = mouse_reports[0];
+        }
+        k_spin_unlock(&mouse_queue_lock, key);
+
+        if (!pending) {
+            break;
+        }
 
         struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc.attrs[10],
+            .attr = &hog_svc.attrs[13],
             .data = &report,
             .len = sizeof(report),
         };
 
         int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err) {
+        if (err == -ENOMEM) {
+            // The report stays queued, with later movement merging into the ones after it.
+            k_work_schedule_for_queue(&hog_work_q, k_work_delayable_from_work(work),
+                                      SEND_RETRY_DELAY);
+            break;
+        } else if (err) {
             LOG_DBG("Error notifying %d", err);
+        } else {
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SENT, 1);
         }
 
-        bt_conn_unref(conn);
+        key = k_spin_lock(&mouse_queue_lock);
+        remove_mouse_report(0);
+        k_spin_unlock(&mouse_queue_lock, key);
     }
+
+    bt_conn_unref(conn);
 };
 
-K_WORK_DEFINE(hog_consumer_work, send_consumer_report_callback);
+static K_WORK_DELAYABLE_DEFINE(hog_mouse_work, send_mouse_report_callback);
 
-int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *report) {
-    int err = k_msgq_put(&zmk_hog_consumer_msgq, report, K_MSEC(100));
+int zmk_hog_send_mouse_report(struct zmk_hid_mouse_report_body *report) {
+    k_spinlock_key_t key = k_spin_lock(&mouse_queue_lock);
+    push_mouse_report(report);
+    k_spin_unlock(&mouse_queue_lock, key);
+
+    k_work_schedule_for_queue(&hog_work_q, &hog_mouse_work, K_NO_WAIT);
+
+    return 0;
+};
+
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+// Telemetry is lossy by design: only the latest frame waits to be sent.
+static struct zmk_hid_telemetry_report_body pending_telemetry;
+static bool telemetry_pending;
+static struct k_spinlock telemetry_lock;
+
+static void send_telemetry_callback(struct k_work *work) {
+    struct zmk_hid_telemetry_report_body report;
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    bool pending = telemetry_pending;
+    report = pending_telemetry;
+    telemetry_pending = false;
+    k_spin_unlock(&telemetry_lock, key);
+
+    if (!pending) {
+        return;
+    }
+
+    struct bt_conn *conn = zmk_ble_active_profile_conn();
+    if (conn == NULL) {
+        return;
+    }
+
+    struct bt_gatt_notify_params notify_params = {
+        .attr = &hog_svc.attrs[HOG_TELEMETRY_ATTR],
+        .data = &report,
+        .len = sizeof(report),
+    };
+
+    int err = bt_gatt_notify_cb(conn, &notify_params);
     if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Consumer message queue full, popping first message and queueing again");
-            struct zmk_hid_consumer_report_body discarded_report;
-            k_msgq_get(&zmk_hog_consumer_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_consumer_report(report);
-        }
-        default:
-            LOG_WRN("Failed to queue consumer report to send (%d)", err);
-            return err;
-        }
+        LOG_DBG("Error notifying telemetry %d", err);
     }
 
-    k_work_submit_to_queue(&hog_work_q, &hog_consumer_work);
+    bt_conn_unref(conn);
+}
+
+K_WORK_DEFINE(hog_telemetry_work, send_telemetry_callback);
+
+int zmk_hog_send_telemetry_report(struct zmk_hid_telemetry_report_body *report) {
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    pending_telemetry = *report;
+    telemetry_pending = true;
+    k_spin_unlock(&telemetry_lock, key);
+
+    k_work_submit_to_queue(&hog_work_q, &hog_telemetry_work);
 
     return 0;
-};
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_TELEMETRY) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY)
+
+// Sent straight to a host that is no longer the active profile, bypassing the queues which always
+// go to the active one.
+int zmk_hog_send_release_reports(struct bt_conn *conn) {
+    struct zmk_hid_keyboard_report_body keyboard_report = {0};
+    struct zmk_hid_consumer_report_body consumer_report = {0};
+    struct bt_gatt_notify_params params[] = {
+        {.attr = &hog_svc.attrs[5], .data = &keyboard_report, .len = sizeof(keyboard_report)},
+        {.attr = &hog_svc.attrs[10], .data = &consumer_report, .len = sizeof(consumer_report)},
+    };
+
+    int err = bt_gatt_notify_multiple(conn, ARRAY_SIZE(params), params);
+    if (err) {
+        LOG_WRN("Failed to release keys on the previous host (err %d)", err);
+        return err;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    struct zmk_hid_mouse_report_body mouse_report = {0};
+    struct bt_gatt_notify_params mouse_params = {
+        .attr = &hog_svc.attrs[13],
+        .data = &mouse_report,
+        .len = sizeof(mouse_report),
+    };
+
+    err = bt_gatt_notify_cb(conn, &mouse_params);
+    if (err) {
+        LOG_WRN("Failed to release mouse buttons on the previous host (err %d)", err);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+    return err;
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_HOT_STANDBY) */
 
 int zmk_hog_init(const struct device *_arg) {
     static const struct k_work_queue_config queue_config = {.name = "HID Over GATT Send Work"};
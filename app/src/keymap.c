@@ -19,6 +19,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #if ZMK_BLE_IS_CENTRAL
 #include <zmk/split/bluetooth/central.h>
 #endif
+#include <zmk/split/wired/central.h>
 
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
@@ -212,6 +213,12 @@ int zmk_keymap_apply_position_state(uint8_t source, int layer, uint32_t position
         } else {
             return zmk_split_bt_invoke_behavior(source, &binding, event, pressed);
         }
+#elif ZMK_SPLIT_WIRED_IS_CENTRAL
+        if (source == ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL) {
+            return invoke_locally(&binding, event, pressed);
+        } else {
+            return zmk_split_wired_invoke_behavior(source, &binding, event, pressed);
+        }
 #else
         return invoke_locally(&binding, event, pressed);
 #endif
@@ -220,6 +227,8 @@ int zmk_keymap_apply_position_state(uint8_t source, int layer, uint32_t position
         for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
             zmk_split_bt_invoke_behavior(i, &binding, event, pressed);
         }
+#elif ZMK_SPLIT_WIRED_IS_CENTRAL
+        zmk_split_wired_invoke_behavior(0, &binding, event, pressed);
 #endif
         return invoke_locally(&binding, event, pressed);
     }
@@ -15,6 +15,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/matrix_transform.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
+#include <zmk/latency.h>
+#include <zmk/telemetry.h>
 
 #define ZMK_KSCAN_EVENT_STATE_PRESSED 0
 #define ZMK_KSCAN_EVENT_STATE_RELEASED 1
@@ -23,6 +25,8 @@ struct zmk_kscan_event {
     uint32_t row;
     uint32_t column;
     uint32_t state;
+    // When the driver reported the transition, which can be a while before it is processed
+    int64_t ticks;
 };
 
 struct zmk_kscan_msg_processor {
@@ -36,9 +40,12 @@ static void zmk_kscan_callback(const struct device *dev, uint32_t row, uint32_t
     struct zmk_kscan_event ev = {
         .row = row,
         .column = column,
-        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED)};
+        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED),
+        .ticks = k_uptime_ticks()};
 
     k_msgq_put(&zmk_kscan_msgq, &ev, K_NO_WAIT);
+    zmk_telemetry_add(ZMK_TELEMETRY_KSCAN_EVENTS, 1);
+    zmk_telemetry_queue_used(ZMK_TELEMETRY_QUEUE_KSCAN, k_msgq_num_used_get(&zmk_kscan_msgq));
     k_work_submit(&msg_processor.work);
 }
 
@@ -50,11 +57,15 @@ void zmk_kscan_process_msgq(struct k_work *item) {
         uint32_t position = zmk_matrix_transform_row_column_to_position(ev.row, ev.column);
         LOG_DBG("Row: %d, col: %d, position: %d, pressed: %s", ev.row, ev.column, position,
                 (pressed ? "true" : "false"));
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+        zmk_latency_transition_detected(ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
+                                        k_ticks_to_ms_floor64(ev.ticks), ev.ticks);
+#endif
         ZMK_EVENT_RAISE(new_zmk_position_state_changed(
             (struct zmk_position_state_changed){.source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
                                                 .state = pressed,
                                                 .position = position,
-                                                .timestamp = k_uptime_get()}));
+                                                .timestamp = k_ticks_to_ms_floor64(ev.ticks)}));
     }
 }
 
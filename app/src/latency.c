@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <kernel.h>
+#include <init.h>
+#include <stdio.h>
+#include <string.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/ble.h>
+#include <zmk/split/wired/central.h>
+#include <zmk/latency.h>
+#include <zmk/events/position_state_changed.h>
+
+#if IS_ENABLED(CONFIG_SHELL)
+#include <shell/shell.h>
+#endif
+
+#if ZMK_BLE_IS_CENTRAL
+#define SOURCE_COUNT (ZMK_BLE_SPLIT_PERIPHERAL_COUNT + 1)
+#elif ZMK_SPLIT_WIRED_IS_CENTRAL
+#define SOURCE_COUNT 2
+#else
+#define SOURCE_COUNT 1
+#endif
+
+#define BUCKET_US CONFIG_ZMK_LATENCY_PROBE_BUCKET_US
+#define BUCKET_COUNT CONFIG_ZMK_LATENCY_PROBE_BUCKETS
+
+// Transitions that take longer than this to reach a report were most likely made while no endpoint
+// was connected, and would only skew the results.
+#define PENDING_TIMEOUT_MS 1000
+
+#define TRANSITION_QUEUE_SIZE 8
+
+struct transition {
+    uint8_t source;
+    int64_t timestamp;
+    int64_t ticks;
+    // Set once its keycode changes, to tell which reports carry it
+    uint16_t usage_page;
+    uint32_t keycode_sequence;
+};
+
+struct transition_queue {
+    struct transition items[TRANSITION_QUEUE_SIZE];
+    uint8_t count;
+};
+
+struct latency_histogram {
+    // The last bucket also holds everything beyond it
+    uint32_t buckets[BUCKET_COUNT];
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+static struct k_spinlock lock;
+// Transitions that no keycode event has been raised for yet
+static struct transition_queue detected;
+// Transitions whose keycode changed, waiting for a report that carries them to be handed to an
+// endpoint
+static struct transition_queue pending;
+static uint32_t keycode_sequence;
+static struct latency_histogram histograms[SOURCE_COUNT];
+
+static int source_index(uint8_t source) {
+    if (source == ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL) {
+        return 0;
+    }
+
+    if (source < SOURCE_COUNT - 1) {
+        return source + 1;
+    }
+
+    return -EINVAL;
+}
+
+static void remove_transition(struct transition_queue *queue, int index) {
+    memmove(&queue->items[index], &queue->items[index + 1],
+            (queue->count - index - 1) * sizeof(queue->items[0]));
+    queue->count--;
+}
+
+static void push_transition(struct transition_queue *queue, const struct transition *transition) {
+    if (queue->count == TRANSITION_QUEUE_SIZE) {
+        // Most transitions never get a keycode (layer keys, for one), so the oldest one goes.
+        remove_transition(queue, 0);
+    }
+
+    queue->items[queue->count++] = *transition;
+}
+
+static void record_latency(int index, uint32_t latency_us) {
+    struct latency_histogram *histogram = &histograms[index];
+
+    histogram->buckets[MIN(latency_us / BUCKET_US, BUCKET_COUNT - 1)]++;
+    histogram->sum_us += latency_us;
+    if (histogram->count == 0 || latency_us < histogram->min_us) {
+        histogram->min_us = latency_us;
+    }
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us;
+    }
+    histogram->count++;
+}
+
+void zmk_latency_transition_detected(uint8_t source, int64_t timestamp, int64_t ticks) {
+    if (source_index(source) < 0) {
+        return;
+    }
+
+    struct transition transition = {.source = source, .timestamp = timestamp, .ticks = ticks};
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    push_transition(&detected, &transition);
+    k_spin_unlock(&lock, key);
+}
+
+void zmk_latency_keycode_changed(uint16_t usage_page, int64_t timestamp) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    keycode_sequence++;
+
+    // Keycode events carry the timestamp of the position event that caused them, which is enough
+    // to find its precise detection time again.
+    for (int i = detected.count - 1; i >= 0; i--) {
+        if (detected.items[i].timestamp == timestamp) {
+            detected.items[i].usage_page = usage_page;
+            detected.items[i].keycode_sequence = keycode_sequence;
+            push_transition(&pending, &detected.items[i]);
+            remove_transition(&detected, i);
+            break;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+uint32_t zmk_latency_keycode_sequence() {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t sequence = keycode_sequence;
+    k_spin_unlock(&lock, key);
+
+    return sequence;
+}
+
+void zmk_latency_report_sent(uint16_t usage_page, uint32_t sequence) {
+    int64_t now = k_uptime_ticks();
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    // Every report holds the complete state, so the first one of the right usage page handed off
+    // after a keycode change is the one that carries it to the host. Reports queued before the
+    // change don't.
+    for (int i = pending.count - 1; i >= 0; i--) {
+        const struct transition *transition = &pending.items[i];
+        if (transition->usage_page != usage_page ||
+            (int32_t)(transition->keycode_sequence - sequence) > 0) {
+            continue;
+        }
+
+        int64_t elapsed = now - transition->ticks;
+        if (k_ticks_to_ms_floor64(elapsed) < PENDING_TIMEOUT_MS) {
+            record_latency(source_index(transition->source), k_ticks_to_us_floor32(elapsed));
+        }
+        remove_transition(&pending, i);
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+static void get_stats(int index, struct zmk_latency_stats *stats) {
+    const struct latency_histogram *histogram = &histograms[index];
+
+    *stats = (struct zmk_latency_stats){.count = histogram->count};
+    if (histogram->count == 0) {
+        return;
+    }
+
+    stats->min_us = histogram->min_us;
+    stats->max_us = histogram->max_us;
+    stats->avg_us = histogram->sum_us / histogram->count;
+
+    uint32_t p99_rank = (histogram->count * 99 + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= p99_rank) {
+            stats->p99_us = MIN((i + 1) * BUCKET_US, histogram->max_us);
+            break;
+        }
+    }
+}
+
+int zmk_latency_get_stats(uint8_t source, struct zmk_latency_stats *stats) {
+    int index = source_index(source);
+    if (index < 0) {
+        return index;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    get_stats(index, stats);
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+int zmk_latency_get_histogram(uint8_t source, uint32_t *buckets, size_t count) {
+    int index = source_index(source);
+    if (index < 0) {
+        return index;
+    }
+
+    count = MIN(count, BUCKET_COUNT);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memcpy(buckets, histograms[index].buckets, count * sizeof(buckets[0]));
+    k_spin_unlock(&lock, key);
+
+    return count;
+}
+
+void zmk_latency_reset() {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memset(histograms, 0, sizeof(histograms));
+    detected.count = 0;
+    pending.count = 0;
+    k_spin_unlock(&lock, key);
+}
+
+static void snapshot_stats(struct zmk_latency_stats stats[SOURCE_COUNT]) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (int i = 0; i < SOURCE_COUNT; i++) {
+        get_stats(i, &stats[i]);
+    }
+    k_spin_unlock(&lock, key);
+}
+
+static const char *source_name(int index, char *buf, size_t len) {
+    if (index == 0) {
+        return "local";
+    }
+
+    snprintf(buf, len, "peripheral %d", index - 1);
+    return buf;
+}
+
+#define STATS_FMT "%s: %u transitions, min %u avg %u p99 %u max %u us"
+#define STATS_ARGS(name, stats)                                                                    \
+    (name), (stats).count, (stats).min_us, (stats).avg_us, (stats).p99_us, (stats).max_us
+
+#if CONFIG_ZMK_LATENCY_PROBE_LOG_INTERVAL > 0
+
+static void latency_log_work_handler(struct k_work *work) {
+    struct zmk_latency_stats stats[SOURCE_COUNT];
+    snapshot_stats(stats);
+
+    for (int i = 0; i < SOURCE_COUNT; i++) {
+        if (stats[i].count > 0) {
+            char name[16];
+            const char *source = log_strdup(source_name(i, name, sizeof(name)));
+            LOG_INF(STATS_FMT, STATS_ARGS(source, stats[i]));
+        }
+    }
+
+    k_work_schedule(k_work_delayable_from_work(work),
+                    K_SECONDS(CONFIG_ZMK_LATENCY_PROBE_LOG_INTERVAL));
+}
+
+static K_WORK_DELAYABLE_DEFINE(latency_log_work, latency_log_work_handler);
+
+#endif /* CONFIG_ZMK_LATENCY_PROBE_LOG_INTERVAL > 0 */
+
+#if IS_ENABLED(CONFIG_SHELL)
+
+static int cmd_latency_show(const struct shell *shell, size_t argc, char **argv) {
+    struct zmk_latency_stats stats[SOURCE_COUNT];
+    snapshot_stats(stats);
+
+    for (int i = 0; i < SOURCE_COUNT; i++) {
+        char name[16];
+        shell_print(shell, STATS_FMT, STATS_ARGS(source_name(i, name, sizeof(name)), stats[i]));
+    }
+
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *shell, size_t argc, char **argv) {
+    zmk_latency_reset();
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_latency,
+                               SHELL_CMD(show, NULL, "Show input latency per source",
+                                         cmd_latency_show),
+                               SHELL_CMD(reset, NULL, "Clear input latency results",
+                                         cmd_latency_reset),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(latency, &sub_latency, "Input latency probe", NULL);
+
+#endif /* IS_ENABLED(CONFIG_SHELL) */
+
+static int zmk_latency_init(const struct device *_arg) {
+#if CONFIG_ZMK_LATENCY_PROBE_LOG_INTERVAL > 0
+    k_work_schedule(&latency_log_work, K_SECONDS(CONFIG_ZMK_LATENCY_PROBE_LOG_INTERVAL));
+#endif
+
+    return 0;
+}
+
+SYS_INIT(zmk_latency_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <kernel.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/mouse.h>
+#include <zmk/hid.h>
+#include <zmk/ble.h>
+#include <zmk/endpoints.h>
+
+// Used when the current endpoint can't tell us how often it accepts reports.
+#define FALLBACK_REPORT_INTERVAL_US (10 * USEC_PER_MSEC)
+
+// Movement from behaviors and sensors can arrive on different threads than the one sending
+// reports, so all accumulator access goes through this lock.
+static struct k_spinlock mouse_lock;
+static int64_t last_report_ticks;
+
+static void mouse_report_work_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(mouse_report_work, mouse_report_work_callback);
+
+static uint32_t mouse_report_interval_us() {
+    switch (zmk_endpoints_selected()) {
+#if IS_ENABLED(CONFIG_ZMK_USB)
+    case ZMK_ENDPOINT_USB:
+        return CONFIG_USB_HID_POLL_INTERVAL_MS * USEC_PER_MSEC;
+#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    case ZMK_ENDPOINT_BLE: {
+        // Connection interval is in units of 1.25 ms
+        uint16_t interval = zmk_ble_active_profile_conn_interval();
+        if (interval > 0) {
+            return interval * 1250;
+        }
+        break;
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+
+    default:
+        break;
+    }
+
+    return FALLBACK_REPORT_INTERVAL_US;
+}
+
+static int send_mouse_report() {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    bool pending = zmk_hid_mouse_prepare_report();
+    k_spin_unlock(&mouse_lock, key);
+
+    if (!pending) {
+        return 0;
+    }
+
+    last_report_ticks = k_uptime_ticks();
+    return zmk_endpoints_send_mouse_report();
+}
+
+static void schedule_mouse_report() {
+    // Anything added while a report is already scheduled gets merged into that report.
+    if (k_work_delayable_is_pending(&mouse_report_work)) {
+        return;
+    }
+
+    int64_t next_report_ticks =
+        last_report_ticks + k_us_to_ticks_ceil64(mouse_report_interval_us());
+    int64_t delay = MAX(next_report_ticks - k_uptime_ticks(), 0);
+
+    k_work_schedule(&mouse_report_work, K_TICKS(delay));
+}
+
+static void mouse_report_work_callback(struct k_work *work) {
+    int err = send_mouse_report();
+    if (err) {
+        LOG_ERR("Failed to send mouse report (%d)", err);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    bool pending = zmk_hid_mouse_has_pending();
+    k_spin_unlock(&mouse_lock, key);
+
+    // Deltas too large for one report are sent at the next opportunity.
+    if (pending) {
+        schedule_mouse_report();
+    }
+}
+
+int zmk_mouse_move(int16_t x, int16_t y) {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    zmk_hid_mouse_movement_add(x, y);
+    k_spin_unlock(&mouse_lock, key);
+
+    schedule_mouse_report();
+    return 0;
+}
+
+int zmk_mouse_scroll(int16_t x, int16_t y) {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    zmk_hid_mouse_scroll_add(x, y);
+    k_spin_unlock(&mouse_lock, key);
+
+    schedule_mouse_report();
+    return 0;
+}
+
+// Button changes are sent right away, together with any movement accumulated so far, so a quick
+// click can't be merged away before the next scheduled report.
+int zmk_mouse_buttons_press(zmk_mouse_button_flags_t buttons) {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    zmk_hid_mouse_buttons_press(buttons);
+    k_spin_unlock(&mouse_lock, key);
+
+    return send_mouse_report();
+}
+
+int zmk_mouse_buttons_release(zmk_mouse_button_flags_t buttons) {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    zmk_hid_mouse_buttons_release(buttons);
+    k_spin_unlock(&mouse_lock, key);
+
+    return send_mouse_report();
+}
+
+void zmk_mouse_clear() {
+    k_spinlock_key_t key = k_spin_lock(&mouse_lock);
+    zmk_hid_mouse_clear();
+    k_spin_unlock(&mouse_lock, key);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+#include <kernel.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/event_manager.h>
+#include <zmk/events/mouse_button_state_changed.h>
+#include <zmk/events/mouse_move_state_changed.h>
+#include <zmk/events/mouse_scroll_state_changed.h>
+#include <zmk/mouse.h>
+
+#define TICK_DURATION_MS CONFIG_ZMK_MOUSE_TICK_DURATION
+
+// Speed fractions are Q16 fixed point, so 1 << 16 is full speed.
+#define FRACTION_SHIFT 16
+#define FRACTION_ONE BIT(FRACTION_SHIFT)
+
+// Distances are accumulated in thousandths of a pixel (or scroll detent), which is what a speed
+// in units per second times a duration in milliseconds produces.
+#define SUBUNITS_PER_UNIT 1000
+
+struct movement_state {
+    struct zmk_mouse_movement_config config;
+    // Sum of the speeds of all held keys, in units per second
+    int32_t max_speed_x;
+    int32_t max_speed_y;
+    // Number of ticks since the first key was pressed, drives the acceleration curve
+    uint32_t ticks;
+    // Sub-unit distance not sent yet, carried into the next tick
+    int32_t remainder_x;
+    int32_t remainder_y;
+    uint8_t held_count;
+};
+
+static struct movement_state move_state;
+static struct movement_state scroll_state;
+static bool tick_timer_running;
+
+static void mouse_listener_tick(struct k_work *work);
+
+K_WORK_DEFINE(mouse_tick_work, mouse_listener_tick);
+
+static void mouse_tick_expiry_function(struct k_timer *timer) { k_work_submit(&mouse_tick_work); }
+
+K_TIMER_DEFINE(mouse_tick_timer, mouse_tick_expiry_function, NULL);
+
+static uint32_t speed_fraction(const struct zmk_mouse_movement_config *config,
+                               uint32_t elapsed_ms) {
+    if (elapsed_ms >= config->time_to_max_speed_ms) {
+        return FRACTION_ONE;
+    }
+
+    uint32_t linear = (elapsed_ms << FRACTION_SHIFT) / config->time_to_max_speed_ms;
+    uint32_t fraction = FRACTION_ONE;
+    for (int i = 0; i < config->acceleration_exponent; i++) {
+        fraction = ((uint64_t)fraction * linear) >> FRACTION_SHIFT;
+    }
+
+    return fraction;
+}
+
+static int32_t scale_speed(int32_t max_speed, uint32_t fraction) {
+    // Round to the nearest unit, symmetrically for both directions.
+    uint32_t magnitude =
+        ((uint64_t)abs(max_speed) * fraction + BIT(FRACTION_SHIFT - 1)) >> FRACTION_SHIFT;
+    return max_speed < 0 ? -(int32_t)magnitude : (int32_t)magnitude;
+}
+
+static int16_t advance_axis(int32_t speed, int32_t *remainder) {
+    *remainder += speed * TICK_DURATION_MS;
+    int16_t delta = *remainder / SUBUNITS_PER_UNIT;
+    *remainder -= delta * SUBUNITS_PER_UNIT;
+    return delta;
+}
+
+static bool advance_movement(struct movement_state *state, int16_t *dx, int16_t *dy) {
+    if (state->held_count == 0) {
+        return false;
+    }
+
+    state->ticks++;
+    uint32_t fraction = speed_fraction(&state->config, state->ticks * TICK_DURATION_MS);
+
+    *dx = advance_axis(scale_speed(state->max_speed_x, fraction), &state->remainder_x);
+    *dy = advance_axis(scale_speed(state->max_speed_y, fraction), &state->remainder_y);
+
+    return *dx != 0 || *dy != 0;
+}
+
+static void mouse_listener_tick(struct k_work *work) {
+    int16_t dx, dy;
+
+    if (advance_movement(&move_state, &dx, &dy)) {
+        LOG_DBG("move x %d y %d", dx, dy);
+        zmk_mouse_move(dx, dy);
+    }
+
+    if (advance_movement(&scroll_state, &dx, &dy)) {
+        LOG_DBG("scroll x %d y %d", dx, dy);
+        zmk_mouse_scroll(dx, dy);
+    }
+}
+
+static void update_tick_timer() {
+    bool needed = move_state.held_count > 0 || scroll_state.held_count > 0;
+
+    if (needed && !tick_timer_running) {
+        k_timer_start(&mouse_tick_timer, K_MSEC(TICK_DURATION_MS), K_MSEC(TICK_DURATION_MS));
+    } else if (!needed && tick_timer_running) {
+        k_timer_stop(&mouse_tick_timer);
+    }
+    tick_timer_running = needed;
+}
+
+static void movement_key_changed(struct movement_state *state,
+                                 const struct zmk_mouse_movement_config *config, int16_t speed_x,
+                                 int16_t speed_y, bool pressed) {
+    if (pressed) {
+        if (state->held_count == 0) {
+            *state = (struct movement_state){0};
+        }
+        // The most recently pressed key decides the acceleration curve.
+        state->config = *config;
+        state->max_speed_x += speed_x;
+        state->max_speed_y += speed_y;
+        state->held_count++;
+    } else if (state->held_count > 0) {
+        state->max_speed_x -= speed_x;
+        state->max_speed_y -= speed_y;
+        state->held_count--;
+    }
+
+    update_tick_timer();
+}
+
+static int mouse_listener_button_pressed(const struct zmk_mouse_button_state_changed *ev) {
+    LOG_DBG("buttons 0x%02X", ev->buttons);
+    return zmk_mouse_buttons_press(ev->buttons);
+}
+
+static int mouse_listener_button_released(const struct zmk_mouse_button_state_changed *ev) {
+    LOG_DBG("buttons 0x%02X", ev->buttons);
+    return zmk_mouse_buttons_release(ev->buttons);
+}
+
+int mouse_listener(const zmk_event_t *eh) {
+    const struct zmk_mouse_button_state_changed *button_ev = as_zmk_mouse_button_state_changed(eh);
+    if (button_ev) {
+        if (button_ev->state) {
+            mouse_listener_button_pressed(button_ev);
+        } else {
+            mouse_listener_button_released(button_ev);
+        }
+        return 0;
+    }
+
+    const struct zmk_mouse_move_state_changed *move_ev = as_zmk_mouse_move_state_changed(eh);
+    if (move_ev) {
+        movement_key_changed(&move_state, &move_ev->config, move_ev->max_speed_x,
+                             move_ev->max_speed_y, move_ev->state);
+        return 0;
+    }
+
+    const struct zmk_mouse_scroll_state_changed *scroll_ev = as_zmk_mouse_scroll_state_changed(eh);
+    if (scroll_ev) {
+        movement_key_changed(&scroll_state, &scroll_ev->config, scroll_ev->max_speed_x,
+                             scroll_ev->max_speed_y, scroll_ev->state);
+        return 0;
+    }
+
+    return 0;
+}
+
+ZMK_LISTENER(mouse_listener, mouse_listener);
+ZMK_SUBSCRIPTION(mouse_listener, zmk_mouse_button_state_changed);
+ZMK_SUBSCRIPTION(mouse_listener, zmk_mouse_move_state_changed);
+ZMK_SUBSCRIPTION(mouse_listener, zmk_mouse_scroll_state_changed);
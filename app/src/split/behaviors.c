@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <device.h>
+#include <init.h>
+#include <string.h>
+#include <sys/crc.h>
+#include <sys/util.h>
+#include <drivers/behavior.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/behavior.h>
+#include <zmk/split/behaviors.h>
+
+// Behaviors whose locality lets the central invoke them on peripherals. Both halves build the
+// table from the same devicetree, so a behavior's index is the same on each. Add the compatible of
+// any new global or event source behavior here.
+#define BEHAVIOR_LABEL(node) DT_LABEL(node),
+
+#define SPLIT_BEHAVIOR_LABELS                                                                      \
+    DT_FOREACH_STATUS_OKAY(zmk_behavior_reset, BEHAVIOR_LABEL)                                     \
+    DT_FOREACH_STATUS_OKAY(zmk_behavior_ext_power, BEHAVIOR_LABEL)                                 \
+    DT_FOREACH_STATUS_OKAY(zmk_behavior_rgb_underglow, BEHAVIOR_LABEL)                             \
+    DT_FOREACH_STATUS_OKAY(zmk_behavior_backlight, BEHAVIOR_LABEL)
+
+static const char *const behavior_labels[] = {SPLIT_BEHAVIOR_LABELS};
+
+BUILD_ASSERT(ARRAY_SIZE(behavior_labels) <= UINT8_MAX, "Too many split behaviors");
+
+// Resolved at init, since a behavior's driver may not be built on this half.
+static const struct device *behavior_devices[ARRAY_SIZE(behavior_labels)];
+static uint32_t behaviors_hash;
+
+int zmk_split_behavior_id(const char *behavior_dev) {
+    for (int i = 0; i < ARRAY_SIZE(behavior_labels); i++) {
+        if (strcmp(behavior_labels[i], behavior_dev) == 0) {
+            return i;
+        }
+    }
+
+    return -ENODEV;
+}
+
+const struct device *zmk_split_behavior_device(uint8_t id) {
+    if (id >= ARRAY_SIZE(behavior_devices)) {
+        return NULL;
+    }
+
+    return behavior_devices[id];
+}
+
+uint32_t zmk_split_behaviors_hash() { return behaviors_hash; }
+
+int zmk_split_behavior_run(uint8_t id, uint32_t param1, uint32_t param2, uint32_t position,
+                           bool state) {
+    const struct device *behavior = zmk_split_behavior_device(id);
+
+    if (behavior == NULL) {
+        LOG_ERR("Unknown behavior %d", id);
+        return -ENODEV;
+    }
+
+    struct zmk_behavior_binding binding = {
+        .param1 = param1,
+        .param2 = param2,
+        .behavior_dev = (char *)behavior->name,
+    };
+    LOG_DBG("%s with params %d %d: pressed? %d", log_strdup(binding.behavior_dev), binding.param1,
+            binding.param2, state);
+    struct zmk_behavior_binding_event event = {.position = position,
+                                               .timestamp = k_uptime_get()};
+
+    // Dispatch straight to the driver, rather than looking the device up by name again.
+    const struct behavior_driver_api *api = behavior->api;
+    behavior_keymap_binding_callback_t callback =
+        state ? api->binding_pressed : api->binding_released;
+
+    int err = callback != NULL ? callback(&binding, event) : -ENOTSUP;
+    if (err < 0) {
+        LOG_ERR("Failed to invoke behavior %s: %d", log_strdup(binding.behavior_dev), err);
+    }
+
+    return err;
+}
+
+static int split_behaviors_init(const struct device *_arg) {
+    uint32_t hash = 0;
+
+    for (int i = 0; i < ARRAY_SIZE(behavior_labels); i++) {
+        behavior_devices[i] = device_get_binding(behavior_labels[i]);
+        // Include the terminator so the boundaries between labels count.
+        hash = crc32_ieee_update(hash, behavior_labels[i], strlen(behavior_labels[i]) + 1);
+    }
+
+    behaviors_hash = hash;
+
+    return 0;
+}
+
+SYS_INIT(split_behaviors_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
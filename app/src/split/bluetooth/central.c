@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <zephyr/types.h>
 
 #include <bluetooth/bluetooth.h>
@@ -12,6 +14,7 @@
 #include <bluetooth/gatt.h>
 #include <bluetooth/hci.h>
 #include <sys/byteorder.h>
+#include <settings/settings.h>
 
 #include <logging/log.h>
 
@@ -20,15 +23,107 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/stdlib.h>
 #include <zmk/ble.h>
 #include <zmk/behavior.h>
+#include <zmk/matrix.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
+#include <zmk/split/bluetooth/central.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
+#include <zmk/events/layer_state_changed.h>
+#include <zmk/events/endpoint_selection_changed.h>
+#include <zmk/events/ble_active_profile_changed.h>
+#include <zmk/events/battery_state_changed.h>
+#include <zmk/events/split_peripheral_link_changed.h>
+#include <zmk/events/activity_state_changed.h>
+#include <zmk/activity.h>
+#include <zmk/keymap.h>
+#include <zmk/endpoints.h>
+#include <zmk/latency.h>
+#include <zmk/telemetry.h>
 #include <init.h>
 
 static int start_scan(void);
 
-#define POSITION_STATE_DATA_LEN 16
+// The link profile is what the central asks of every peripheral connection. The relaxed parameters
+// let peripherals skip connection events while there's nothing to send them. The active ones drop
+// that latency while typing, so writes to peripherals aren't held up. Peripherals can always send
+// on the next connection event, whatever the latency.
+static const struct bt_le_conn_param relaxed_conn_param = BT_LE_CONN_PARAM_INIT(
+    CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_INTERVAL, CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_INTERVAL,
+    CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_LATENCY, CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_TIMEOUT);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVITY_CONN_PARAMS)
+static const struct bt_le_conn_param active_conn_param = BT_LE_CONN_PARAM_INIT(
+    CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVE_CONN_INTERVAL,
+    CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVE_CONN_INTERVAL,
+    CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVE_CONN_LATENCY, CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_TIMEOUT);
+
+static bool conn_params_active;
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVITY_CONN_PARAMS) */
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_PHY_2M)
+#define SPLIT_LINK_PHY BT_GAP_LE_PHY_2M
+#define SPLIT_LINK_PHY_PARAM BT_CONN_LE_PHY_PARAM_2M
+#else
+#define SPLIT_LINK_PHY BT_GAP_LE_PHY_1M
+#define SPLIT_LINK_PHY_PARAM BT_CONN_LE_PHY_PARAM_1M
+#endif
+
+// The stack starts its own PHY and data length updates as soon as a peripheral connects. The
+// profile's are only requested if those haven't ended up where it wants after this long.
+#define LINK_SETUP_DELAY_MS 1000
+
+static const struct bt_le_conn_param *split_conn_param() {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVITY_CONN_PARAMS)
+    if (conn_params_active) {
+        return &active_conn_param;
+    }
+#endif
+    return &relaxed_conn_param;
+}
+
+// Peripherals report positions in the combined keymap, so they all fit in ours.
+#define POSITION_STATE_DATA_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+#define SNAPSHOT_DATA_LEN (sizeof(struct zmk_split_position_snapshot) + POSITION_STATE_DATA_LEN)
+
+// Estimates the offset between a peripheral's clock and ours, as the smallest difference between a
+// notification arriving and the peripheral's timestamp in it. The minimum of the last two windows
+// of samples is used, so the estimate follows clock drift and recovers from outliers.
+#define CLOCK_OFFSET_WINDOW 16
+// Anything later than this after the estimate means the peripheral's clock has been reset.
+#define CLOCK_OFFSET_MAX_EXCESS_MS 1000
+
+struct peripheral_clock {
+    bool valid;
+    uint16_t offset;
+    uint16_t window_min;
+    uint8_t window_samples;
+};
+
+// Position event batches that arrive while a snapshot is being read are held until it has been
+// applied, since they may carry events the snapshot doesn't cover yet.
+#define HELD_BATCHES_MAX 4
+
+struct held_batch {
+    struct zmk_split_position_events batch;
+    uint8_t count;
+    int64_t sent;
+    int64_t ticks;
+};
+
+// Handles discovered on a peripheral, kept so reconnecting can skip discovery. They're only trusted
+// while the peripheral's GATT database hash stays the same.
+struct peripheral_handle_cache {
+    bt_addr_le_t addr;
+    uint8_t db_hash[16];
+    uint16_t position_state_handle;
+    uint16_t position_events_handle;
+    uint16_t position_events_ccc_handle;
+    uint16_t run_behavior_handle;
+    uint16_t central_state_handle;
+};
+
+static struct peripheral_handle_cache handle_caches[ZMK_BLE_SPLIT_PERIPHERAL_COUNT];
 
 enum peripheral_slot_state {
     PERIPHERAL_SLOT_STATE_OPEN,
@@ -42,13 +137,46 @@ struct peripheral_slot {
     struct bt_gatt_discover_params discover_params;
     struct bt_gatt_subscribe_params subscribe_params;
     struct bt_gatt_discover_params sub_discover_params;
+    struct bt_gatt_read_params snapshot_read_params;
+    uint8_t snapshot_data[SNAPSHOT_DATA_LEN];
+    uint16_t snapshot_len;
+    uint16_t position_state_handle;
     uint16_t run_behavior_handle;
+    uint16_t central_state_handle;
+    // Set when the peripheral hasn't been sent the latest central state.
+    bool central_state_stale;
+    struct bt_gatt_read_params behaviors_read_params;
+    // Set once the peripheral's behavior table is known to match ours.
+    bool behaviors_verified;
+    struct bt_gatt_read_params db_hash_read_params;
+    bool handles_cached;
+    int64_t connected_at;
+    bool first_event_seen;
+    // Position events are only applied once a snapshot has been read.
+    bool synced;
+    bool sync_pending;
+    uint8_t next_sequence;
+    struct held_batch held_batches[HELD_BATCHES_MAX];
+    uint8_t held_batch_count;
+    // Set when a batch arrived while all the slots for held ones were taken.
+    bool held_batches_lost;
+    struct peripheral_clock clock;
     uint8_t position_state[POSITION_STATE_DATA_LEN];
-    uint8_t changed_positions[POSITION_STATE_DATA_LEN];
+    struct zmk_split_bt_link_stats link_stats;
+    uint32_t delay_sum_ms;
+    uint32_t delay_count;
+    uint16_t delay_max_ms;
+    // The connection parameters last requested, and whether the PHY and data length have been.
+    const struct bt_le_conn_param *requested_conn_param;
+    bool link_setup_done;
 };
 
 static struct peripheral_slot peripherals[ZMK_BLE_SPLIT_PERIPHERAL_COUNT];
 
+static void split_central_update_state(struct peripheral_slot *slot);
+static void split_central_update_link_info(struct peripheral_slot *slot);
+static void schedule_link_profile(k_timeout_t delay);
+
 static const struct bt_uuid_128 split_service_uuid = BT_UUID_INIT_128(ZMK_SPLIT_BT_SERVICE_UUID);
 
 K_MSGQ_DEFINE(peripheral_event_msgq, sizeof(struct zmk_position_state_changed),
@@ -58,6 +186,15 @@ void peripheral_event_work_callback(struct k_work *work) {
     struct zmk_position_state_changed ev;
     while (k_msgq_get(&peripheral_event_msgq, &ev, K_NO_WAIT) == 0) {
         LOG_DBG("Trigger key position state change for %d", ev.position);
+
+        if (ev.source < ZMK_BLE_SPLIT_PERIPHERAL_COUNT) {
+            struct peripheral_slot *slot = &peripherals[ev.source];
+            uint16_t delay = CLAMP(k_uptime_get() - ev.timestamp, 0, UINT16_MAX);
+            slot->delay_sum_ms += delay;
+            slot->delay_count++;
+            slot->delay_max_ms = MAX(slot->delay_max_ms, delay);
+        }
+
         ZMK_EVENT_RAISE(new_zmk_position_state_changed(ev));
     }
 }
@@ -112,7 +249,9 @@ int release_peripheral_slot(int index) {
                                                         .state = false,
                                                         .timestamp = k_uptime_get()};
 
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
+                if (k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT) != 0) {
+                    LOG_WRN("Position event queue full, dropping release of %d", position);
+                }
                 k_work_submit(&peripheral_event_work);
             }
         }
@@ -120,12 +259,30 @@ int release_peripheral_slot(int index) {
 
     for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
         slot->position_state[i] = 0U;
-        slot->changed_positions[i] = 0U;
     }
 
+    slot->synced = false;
+    slot->sync_pending = false;
+    slot->held_batch_count = 0;
+    slot->held_batches_lost = false;
+    slot->clock.valid = false;
+
+    slot->link_stats = (struct zmk_split_bt_link_stats){.rssi = ZMK_SPLIT_BT_RSSI_UNKNOWN};
+    slot->delay_sum_ms = 0;
+    slot->delay_count = 0;
+    slot->delay_max_ms = 0;
+    slot->requested_conn_param = NULL;
+    slot->link_setup_done = false;
+
     // Clean up previously discovered handles;
     slot->subscribe_params.value_handle = 0;
+    slot->subscribe_params.ccc_handle = 0;
+    slot->handles_cached = false;
+    slot->position_state_handle = 0;
     slot->run_behavior_handle = 0;
+    slot->central_state_handle = 0;
+    slot->central_state_stale = false;
+    slot->behaviors_verified = false;
 
     return 0;
 }
@@ -162,6 +319,267 @@ int confirm_peripheral_slot_conn(struct bt_conn *conn) {
     return 0;
 }
 
+// Returns how many milliseconds longer than the fastest recent notification this one took.
+static uint16_t update_peripheral_clock(struct peripheral_clock *clock, uint16_t remote_timestamp,
+                                        int64_t local_timestamp) {
+    uint16_t sample = (uint16_t)local_timestamp - remote_timestamp;
+
+    if (clock->valid && (int16_t)(sample - clock->offset) > CLOCK_OFFSET_MAX_EXCESS_MS) {
+        LOG_DBG("Peripheral clock jumped, restarting offset estimate");
+        clock->valid = false;
+    }
+
+    if (!clock->valid) {
+        clock->valid = true;
+        clock->offset = sample;
+        clock->window_samples = 0;
+    }
+
+    if (clock->window_samples == 0 || (int16_t)(sample - clock->window_min) < 0) {
+        clock->window_min = sample;
+    }
+
+    if ((int16_t)(sample - clock->offset) < 0) {
+        clock->offset = sample;
+    }
+
+    uint16_t excess = sample - clock->offset;
+
+    if (++clock->window_samples == CLOCK_OFFSET_WINDOW) {
+        clock->offset = clock->window_min;
+        clock->window_samples = 0;
+    }
+
+    return excess;
+}
+
+static void raise_position_change(struct peripheral_slot *slot, uint32_t position, bool pressed,
+                                  int64_t timestamp, int64_t ticks) {
+    struct zmk_position_state_changed ev = {.source = slot - peripherals,
+                                            .position = position,
+                                            .state = pressed,
+                                            .timestamp = timestamp};
+
+    if (!slot->first_event_seen) {
+        slot->first_event_seen = true;
+        LOG_INF("First key event from peripheral %d, %lld ms after connecting (%s handles)",
+                ev.source, k_ticks_to_ms_floor64(ticks) - slot->connected_at,
+                slot->handles_cached ? "cached" : "discovered");
+    }
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    // Measured from arrival, since the timestamp of a peripheral event is only an estimate.
+    zmk_latency_transition_detected(ev.source, ev.timestamp, ticks);
+#endif
+
+    WRITE_BIT(slot->position_state[position / 8], position % 8, pressed);
+
+    if (k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT) != 0) {
+        LOG_WRN("Position event queue full, dropping position %d from peripheral %d", position,
+                ev.source);
+        slot->link_stats.queue_overflows++;
+    }
+    zmk_telemetry_queue_used(ZMK_TELEMETRY_QUEUE_SPLIT,
+                             k_msgq_num_used_get(&peripheral_event_msgq));
+    k_work_submit(&peripheral_event_work);
+}
+
+static void split_central_resync(struct peripheral_slot *slot);
+
+// Returns false if events are missing, in which case a resync has been started.
+static bool apply_position_events(struct peripheral_slot *slot,
+                                  const struct zmk_split_position_events *batch, size_t count,
+                                  int64_t sent, int64_t ticks) {
+    for (int i = 0; i < count; i++) {
+        int8_t offset = (uint8_t)(batch->sequence + i) - slot->next_sequence;
+        if (offset < 0) {
+            // Already applied, from a snapshot read after the event was queued.
+            continue;
+        }
+
+        if (offset > 0) {
+            LOG_WRN("Lost %d position events from peripheral, resynchronizing", offset);
+            slot->link_stats.gaps++;
+            split_central_resync(slot);
+            return false;
+        }
+
+        const struct zmk_split_position_event *event = &batch->events[i];
+        uint16_t position_state = sys_le16_to_cpu(event->position_state);
+        uint16_t position = position_state & ZMK_SPLIT_POSITION_MAX;
+        slot->next_sequence++;
+
+        if (position >= ZMK_KEYMAP_LEN) {
+            LOG_ERR("Invalid position %d from peripheral", position);
+            continue;
+        }
+
+        bool pressed = position_state & ZMK_SPLIT_POSITION_EVENT_PRESSED;
+        bool was_pressed = slot->position_state[position / 8] & BIT(position % 8);
+        if (pressed != was_pressed) {
+            raise_position_change(slot, position, pressed, sent - event->age, ticks);
+        }
+    }
+
+    return true;
+}
+
+static void hold_position_events(struct peripheral_slot *slot,
+                                 const struct zmk_split_position_events *batch, size_t count,
+                                 int64_t sent, int64_t ticks) {
+    if (slot->held_batch_count == HELD_BATCHES_MAX) {
+        slot->held_batches_lost = true;
+        return;
+    }
+
+    struct held_batch *held = &slot->held_batches[slot->held_batch_count++];
+    memcpy(&held->batch, batch,
+           offsetof(struct zmk_split_position_events, events) + count * sizeof(batch->events[0]));
+    held->count = count;
+    held->sent = sent;
+    held->ticks = ticks;
+}
+
+static void apply_held_position_events(struct peripheral_slot *slot) {
+    if (slot->held_batches_lost) {
+        // Events that came after the snapshot may be gone, so take another one.
+        LOG_WRN("Too many position events during resync, resynchronizing again");
+        slot->held_batch_count = 0;
+        slot->held_batches_lost = false;
+        split_central_resync(slot);
+        return;
+    }
+
+    for (int i = 0; i < slot->held_batch_count; i++) {
+        struct held_batch *held = &slot->held_batches[i];
+        if (!apply_position_events(slot, &held->batch, held->count, held->sent, held->ticks)) {
+            // The next snapshot may not cover these either.
+            memmove(&slot->held_batches[0], held, (slot->held_batch_count - i) * sizeof(*held));
+            slot->held_batch_count -= i;
+            return;
+        }
+    }
+
+    slot->held_batch_count = 0;
+}
+
+static uint8_t split_central_snapshot_read_func(struct bt_conn *conn, uint8_t err,
+                                                struct bt_gatt_read_params *params,
+                                                const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (data != NULL) {
+        // Snapshots for big keymaps take several reads. Anything past our keymap is ignored.
+        uint16_t offset = params->single.offset;
+        if (offset < sizeof(slot->snapshot_data)) {
+            uint16_t copy_len = MIN(length, sizeof(slot->snapshot_data) - offset);
+            memcpy(&slot->snapshot_data[offset], data, copy_len);
+            slot->snapshot_len = MAX(slot->snapshot_len, offset + copy_len);
+        }
+
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    slot->sync_pending = false;
+
+    const struct zmk_split_position_snapshot *snapshot = (void *)slot->snapshot_data;
+    uint16_t state_len = slot->snapshot_len - sizeof(*snapshot);
+
+    if (err || slot->snapshot_len < sizeof(*snapshot) ||
+        state_len < MIN(DIV_ROUND_UP(sys_le16_to_cpu(snapshot->position_count), 8),
+                        POSITION_STATE_DATA_LEN)) {
+        LOG_ERR("Failed to read peripheral position state (err %d, length %u)", err,
+                slot->snapshot_len);
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (sys_le16_to_cpu(snapshot->position_count) > ZMK_KEYMAP_LEN) {
+        LOG_WRN("Peripheral has %d positions, ignoring those past %d",
+                sys_le16_to_cpu(snapshot->position_count), ZMK_KEYMAP_LEN);
+    }
+
+    int64_t ticks = k_uptime_ticks();
+    int64_t timestamp = k_ticks_to_ms_floor64(ticks);
+
+    for (int i = 0; i < MIN(state_len, POSITION_STATE_DATA_LEN); i++) {
+        uint8_t changed = snapshot->position_state[i] ^ slot->position_state[i];
+        for (int j = 0; j < 8; j++) {
+            if (changed & BIT(j)) {
+                raise_position_change(slot, (i * 8) + j, snapshot->position_state[i] & BIT(j),
+                                      timestamp, ticks);
+            }
+        }
+    }
+
+    LOG_DBG("Synchronized to peripheral at sequence %d", snapshot->sequence);
+    slot->next_sequence = snapshot->sequence;
+    slot->synced = true;
+
+    apply_held_position_events(slot);
+
+    return BT_GATT_ITER_STOP;
+}
+
+static void split_central_resync(struct peripheral_slot *slot) {
+    slot->synced = false;
+
+    if (slot->sync_pending || !slot->position_state_handle) {
+        return;
+    }
+
+    slot->snapshot_read_params.func = split_central_snapshot_read_func;
+    slot->snapshot_read_params.handle_count = 1;
+    slot->snapshot_read_params.single.handle = slot->position_state_handle;
+    slot->snapshot_read_params.single.offset = 0;
+    slot->snapshot_len = 0;
+
+    int err = bt_gatt_read(slot->conn, &slot->snapshot_read_params);
+    if (err) {
+        LOG_ERR("Failed to read peripheral position state (err %d)", err);
+        return;
+    }
+
+    slot->sync_pending = true;
+}
+
+static uint8_t split_central_behaviors_read_func(struct bt_conn *conn, uint8_t err,
+                                                 struct bt_gatt_read_params *params,
+                                                 const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (err || data == NULL || length != sizeof(uint32_t)) {
+        LOG_ERR("Failed to read peripheral behaviors hash (err %d)", err);
+        return BT_GATT_ITER_STOP;
+    }
+
+    uint32_t hash = sys_get_le32(data);
+    slot->behaviors_verified = hash == zmk_split_behaviors_hash();
+    if (!slot->behaviors_verified) {
+        LOG_ERR("Peripheral behaviors don't match ours (hash 0x%08x, expected 0x%08x). Make sure "
+                "both halves run the same firmware version.",
+                hash, zmk_split_behaviors_hash());
+    }
+
+    return BT_GATT_ITER_STOP;
+}
+
+static void split_central_verify_behaviors(struct peripheral_slot *slot) {
+    slot->behaviors_read_params.func = split_central_behaviors_read_func;
+    slot->behaviors_read_params.handle_count = 1;
+    slot->behaviors_read_params.single.handle = slot->run_behavior_handle;
+    slot->behaviors_read_params.single.offset = 0;
+
+    int err = bt_gatt_read(slot->conn, &slot->behaviors_read_params);
+    if (err) {
+        LOG_ERR("Failed to read peripheral behaviors hash (err %d)", err);
+    }
+}
+
 static uint8_t split_central_notify_func(struct bt_conn *conn,
                                          struct bt_gatt_subscribe_params *params, const void *data,
                                          uint16_t length) {
@@ -180,32 +598,135 @@ static uint8_t split_central_notify_func(struct bt_conn *conn,
 
     LOG_DBG("[NOTIFICATION] data %p length %u", data, length);
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        slot->changed_positions[i] = ((uint8_t *)data)[i] ^ slot->position_state[i];
-        slot->position_state[i] = ((uint8_t *)data)[i];
-        LOG_DBG("data: %d", slot->position_state[i]);
+    slot->link_stats.notifications++;
+
+    const struct zmk_split_position_events *batch = data;
+    const size_t header_len = offsetof(struct zmk_split_position_events, events);
+    size_t count = (length - header_len) / sizeof(batch->events[0]);
+
+    if (length < header_len || count > ZMK_SPLIT_POSITION_EVENTS_MAX) {
+        LOG_ERR("Malformed position events notification (length %u)", length);
+        return BT_GATT_ITER_CONTINUE;
     }
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->changed_positions[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                bool pressed = slot->position_state[i] & BIT(j);
-                struct zmk_position_state_changed ev = {.source =
-                                                            peripheral_slot_index_for_conn(conn),
-                                                        .position = position,
-                                                        .state = pressed,
-                                                        .timestamp = k_uptime_get()};
+    int64_t ticks = k_uptime_ticks();
+    int64_t now = k_ticks_to_ms_floor64(ticks);
+    // When the batch was sent, less the fastest a notification has recently made it here.
+    int64_t sent = now - update_peripheral_clock(&slot->clock, sys_le16_to_cpu(batch->timestamp),
+                                                 now);
 
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
-        }
+    if (!slot->synced) {
+        // The snapshot being read may have been taken before some of these events.
+        hold_position_events(slot, batch, count, sent, ticks);
+        split_central_resync(slot);
+        return BT_GATT_ITER_CONTINUE;
     }
 
+    apply_position_events(slot, batch, count, sent, ticks);
+
     return BT_GATT_ITER_CONTINUE;
 }
 
+static struct peripheral_handle_cache *find_handle_cache(const bt_addr_le_t *addr) {
+    for (int i = 0; i < ARRAY_SIZE(handle_caches); i++) {
+        if (handle_caches[i].position_events_handle != 0 &&
+            !bt_addr_le_cmp(&handle_caches[i].addr, addr)) {
+            return &handle_caches[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void save_handle_cache(struct peripheral_slot *slot, const uint8_t *db_hash) {
+    const bt_addr_le_t *addr = bt_conn_get_dst(slot->conn);
+    struct peripheral_handle_cache *cache = find_handle_cache(addr);
+    if (cache == NULL) {
+        cache = &handle_caches[slot - peripherals];
+    }
+
+    struct peripheral_handle_cache entry = {
+        .position_state_handle = slot->position_state_handle,
+        .position_events_handle = slot->subscribe_params.value_handle,
+        .position_events_ccc_handle = slot->subscribe_params.ccc_handle,
+        .run_behavior_handle = slot->run_behavior_handle,
+        .central_state_handle = slot->central_state_handle,
+    };
+    bt_addr_le_copy(&entry.addr, addr);
+    memcpy(entry.db_hash, db_hash, sizeof(entry.db_hash));
+
+    if (memcmp(cache, &entry, sizeof(entry)) == 0) {
+        return;
+    }
+
+    *cache = entry;
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+    char setting_name[24];
+    sprintf(setting_name, "split/central/handles/%d", cache - handle_caches);
+    settings_save_one(setting_name, cache, sizeof(*cache));
+#endif
+}
+
+static void clear_handle_cache(struct peripheral_handle_cache *cache) {
+    memset(cache, 0, sizeof(*cache));
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+    char setting_name[24];
+    sprintf(setting_name, "split/central/handles/%d", cache - handle_caches);
+    settings_delete(setting_name);
+#endif
+}
+
+static uint8_t split_central_db_hash_read_func(struct bt_conn *conn, uint8_t err,
+                                               struct bt_gatt_read_params *params,
+                                               const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_handle_cache *cache = find_handle_cache(bt_conn_get_dst(conn));
+
+    if (err || data == NULL || length != sizeof(cache->db_hash)) {
+        // Without a hash there's no telling whether cached handles are still right.
+        LOG_WRN("Failed to read peripheral GATT database hash (err %d)", err);
+        if (cache != NULL) {
+            clear_handle_cache(cache);
+        }
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (!slot->handles_cached) {
+        save_handle_cache(slot, data);
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (cache == NULL || memcmp(cache->db_hash, data, sizeof(cache->db_hash)) != 0) {
+        // Subscriptions don't outlive the connection, so reconnecting starts over with discovery.
+        LOG_INF("Peripheral GATT database changed, reconnecting to rediscover it");
+        if (cache != NULL) {
+            clear_handle_cache(cache);
+        }
+        bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    }
+
+    return BT_GATT_ITER_STOP;
+}
+
+static void split_central_read_db_hash(struct peripheral_slot *slot) {
+    slot->db_hash_read_params.func = split_central_db_hash_read_func;
+    slot->db_hash_read_params.handle_count = 0;
+    slot->db_hash_read_params.by_uuid.start_handle = 0x0001;
+    slot->db_hash_read_params.by_uuid.end_handle = 0xffff;
+    slot->db_hash_read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+
+    int err = bt_gatt_read(slot->conn, &slot->db_hash_read_params);
+    if (err) {
+        LOG_WRN("Failed to read peripheral GATT database hash (err %d)", err);
+    }
+}
+
 static void split_central_subscribe(struct bt_conn *conn) {
     struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
     if (slot == NULL) {
@@ -251,6 +772,10 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
     if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                      BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID))) {
         LOG_DBG("Found position state characteristic");
+        slot->position_state_handle = bt_gatt_attr_value_handle(attr);
+    } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
+                            BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID))) {
+        LOG_DBG("Found position events characteristic");
         slot->discover_params.uuid = NULL;
         slot->discover_params.start_handle = attr->handle + 2;
         slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
@@ -260,16 +785,30 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         slot->subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
         slot->subscribe_params.notify = split_central_notify_func;
         slot->subscribe_params.value = BT_GATT_CCC_NOTIFY;
+        atomic_set_bit(slot->subscribe_params.flags, BT_GATT_SUBSCRIBE_FLAG_VOLATILE);
         split_central_subscribe(conn);
     } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                             BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID))) {
         LOG_DBG("Found run behavior handle");
         slot->run_behavior_handle = bt_gatt_attr_value_handle(attr);
+    } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
+                            BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_CENTRAL_STATE_UUID))) {
+        LOG_DBG("Found central state handle");
+        slot->central_state_handle = bt_gatt_attr_value_handle(attr);
     }
 
-    bool subscribed = (slot->run_behavior_handle && slot->subscribe_params.value_handle);
+    bool subscribed = (slot->run_behavior_handle && slot->position_state_handle &&
+                       slot->subscribe_params.value_handle);
+    if (!subscribed) {
+        return BT_GATT_ITER_CONTINUE;
+    }
 
-    return subscribed ? BT_GATT_ITER_STOP : BT_GATT_ITER_CONTINUE;
+    split_central_resync(slot);
+    split_central_verify_behaviors(slot);
+    split_central_read_db_hash(slot);
+    split_central_update_state(slot);
+
+    return BT_GATT_ITER_STOP;
 }
 
 static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
@@ -324,7 +863,29 @@ static void split_central_process_connection(struct bt_conn *conn) {
         return;
     }
 
-    if (!slot->subscribe_params.value_handle) {
+    struct peripheral_handle_cache *cache = find_handle_cache(bt_conn_get_dst(conn));
+
+    if (!slot->subscribe_params.value_handle && cache != NULL) {
+        LOG_DBG("Using cached handles, skipping discovery");
+        slot->handles_cached = true;
+        slot->position_state_handle = cache->position_state_handle;
+        slot->run_behavior_handle = cache->run_behavior_handle;
+        slot->central_state_handle = cache->central_state_handle;
+
+        slot->subscribe_params.value_handle = cache->position_events_handle;
+        slot->subscribe_params.ccc_handle = cache->position_events_ccc_handle;
+        slot->subscribe_params.notify = split_central_notify_func;
+        slot->subscribe_params.value = BT_GATT_CCC_NOTIFY;
+        atomic_set_bit(slot->subscribe_params.flags, BT_GATT_SUBSCRIBE_FLAG_VOLATILE);
+        split_central_subscribe(conn);
+
+        split_central_resync(slot);
+        split_central_verify_behaviors(slot);
+        split_central_update_state(slot);
+        // Checked after the fact, so a stale cache costs a reconnect instead of every connection
+        // waiting on the check.
+        split_central_read_db_hash(slot);
+    } else if (!slot->subscribe_params.value_handle) {
         slot->discover_params.uuid = &split_service_uuid.uuid;
         slot->discover_params.func = split_central_service_discovery_func;
         slot->discover_params.start_handle = 0x0001;
@@ -361,7 +922,7 @@ static bool split_central_eir_found(struct bt_data *data, void *user_data) {
         }
 
         for (i = 0; i < data->data_len; i += 16) {
-            struct bt_le_conn_param *param;
+            const struct bt_le_conn_param *param;
             struct bt_uuid_128 uuid;
             int err;
 
@@ -384,7 +945,12 @@ static bool split_central_eir_found(struct bt_data *data, void *user_data) {
 
             LOG_DBG("Found the split service");
 
-            zmk_ble_set_peripheral_addr(addr);
+            err = zmk_ble_put_peripheral_addr(addr);
+            if (err < 0) {
+                LOG_WRN("Already know %d peripherals, ignoring this one",
+                        ZMK_BLE_SPLIT_PERIPHERAL_COUNT);
+                continue;
+            }
 
             err = bt_le_scan_stop();
             if (err) {
@@ -392,7 +958,7 @@ static bool split_central_eir_found(struct bt_data *data, void *user_data) {
                 continue;
             }
 
-            uint8_t slot_idx = reserve_peripheral_slot();
+            int slot_idx = reserve_peripheral_slot();
             if (slot_idx < 0) {
                 LOG_ERR("Faild to reserve peripheral slot (err %d)", slot_idx);
                 continue;
@@ -404,12 +970,12 @@ static bool split_central_eir_found(struct bt_data *data, void *user_data) {
             if (slot->conn) {
                 LOG_DBG("Found existing connection");
                 split_central_process_connection(slot->conn);
-                err = bt_conn_le_phy_update(slot->conn, BT_CONN_LE_PHY_PARAM_2M);
+                err = bt_conn_le_phy_update(slot->conn, SPLIT_LINK_PHY_PARAM);
                 if (err) {
                     LOG_ERR("Update phy conn failed (err %d)", err);
                 }
             } else {
-                param = BT_LE_CONN_PARAM(0x0006, 0x0006, 30, 400);
+                param = split_conn_param();
 
                 LOG_DBG("Initiating new connnection");
 
@@ -417,6 +983,7 @@ static bool split_central_eir_found(struct bt_data *data, void *user_data) {
                 if (err) {
                     LOG_ERR("Create conn failed (err %d) (create conn? 0x%04x)", err,
                             BT_HCI_OP_LE_CREATE_CONN);
+                    release_peripheral_slot(slot_idx);
                     start_scan();
                 }
             }
@@ -442,10 +1009,79 @@ static void split_central_device_found(const bt_addr_le_t *addr, int8_t rssi, ui
     }
 }
 
+static bool has_open_peripheral_slot() {
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        if (peripherals[i].state == PERIPHERAL_SLOT_STATE_OPEN) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool all_peripherals_known() {
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        if (zmk_ble_get_peripheral_addr(i) == NULL) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The controller only initiates one connection at a time, but with every peripheral in the filter
+// accept list it waits for all of them at once and connects whichever advertises first. It's
+// re-armed as soon as each connection completes, so the last peripheral is ready about as soon as
+// the slowest one advertises.
+static int start_auto_connect(void) {
+    int err = bt_le_filter_accept_list_clear();
+    if (err == -EAGAIN) {
+        // Already waiting on the list.
+        return 0;
+    }
+
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        const bt_addr_le_t *addr = zmk_ble_get_peripheral_addr(i);
+        struct bt_conn *conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr);
+        if (conn != NULL) {
+            bt_conn_unref(conn);
+            continue;
+        }
+
+        err = bt_le_filter_accept_list_add(addr);
+        if (err) {
+            LOG_ERR("Failed to add peripheral %d to the filter accept list (err %d)", i, err);
+            return err;
+        }
+    }
+
+    err = bt_conn_le_create_auto(BT_CONN_LE_CREATE_CONN, split_conn_param());
+    if (err && err != -EALREADY) {
+        LOG_ERR("Failed to start connecting to peripherals (err %d)", err);
+        return err;
+    }
+
+    LOG_DBG("Waiting for peripherals to connect");
+    return 0;
+}
+
 static int start_scan(void) {
     int err;
 
+    if (!has_open_peripheral_slot()) {
+        LOG_DBG("All peripherals connected");
+        return 0;
+    }
+
+    if (all_peripherals_known()) {
+        return start_auto_connect();
+    }
+
     err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, split_central_device_found);
+    if (err == -EALREADY) {
+        return 0;
+    }
+
     if (err) {
         LOG_ERR("Scanning failed to start (err %d)", err);
         return err;
@@ -479,8 +1115,40 @@ static void split_central_connected(struct bt_conn *conn, uint8_t conn_err) {
 
     LOG_DBG("Connected: %s", log_strdup(addr));
 
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        // Connected through the filter accept list, so no slot was reserved up front.
+        int slot_idx = reserve_peripheral_slot();
+        if (slot_idx < 0) {
+            LOG_ERR("No open peripheral slot for %s", log_strdup(addr));
+            bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+            return;
+        }
+
+        slot = &peripherals[slot_idx];
+        slot->conn = bt_conn_ref(conn);
+    }
+
+    slot->connected_at = k_uptime_get();
+    split_central_update_link_info(slot);
+    slot->first_event_seen = false;
+
+    // It was created with the link profile's parameters, unless they've changed since. If so, the
+    // profile work requests the current ones.
+    const struct bt_le_conn_param *param = split_conn_param();
+    if (slot->link_stats.interval == param->interval_max &&
+        slot->link_stats.latency == param->latency) {
+        slot->requested_conn_param = param;
+        slot->link_stats.requested_interval = param->interval_max;
+        slot->link_stats.requested_latency = param->latency;
+    }
+
     confirm_peripheral_slot_conn(conn);
     split_central_process_connection(conn);
+    schedule_link_profile(K_NO_WAIT);
+
+    // Carry on connecting any other peripherals in the meantime.
+    start_scan();
 }
 
 static void split_central_disconnected(struct bt_conn *conn, uint8_t reason) {
@@ -500,9 +1168,75 @@ static void split_central_disconnected(struct bt_conn *conn, uint8_t reason) {
     start_scan();
 }
 
+static void split_central_update_link_info(struct peripheral_slot *slot) {
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(slot->conn, &info)) {
+        return;
+    }
+
+    slot->link_stats.interval = info.le.interval;
+    slot->link_stats.latency = info.le.latency;
+    slot->link_stats.timeout = info.le.timeout;
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    slot->link_stats.tx_phy = info.le.phy->tx_phy;
+    slot->link_stats.rx_phy = info.le.phy->rx_phy;
+#endif
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    slot->link_stats.tx_data_len = info.le.data_len->tx_max_len;
+    slot->link_stats.rx_data_len = info.le.data_len->rx_max_len;
+#endif
+}
+
+static void split_central_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                           uint16_t latency, uint16_t timeout) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return;
+    }
+
+    LOG_DBG("Peripheral %d: interval %d latency %d timeout %d", (int)(slot - peripherals),
+            interval, latency, timeout);
+    split_central_update_link_info(slot);
+}
+
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+static void split_central_le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return;
+    }
+
+    LOG_DBG("Peripheral %d: PHY tx %d rx %d", (int)(slot - peripherals), param->tx_phy,
+            param->rx_phy);
+    split_central_update_link_info(slot);
+}
+#endif /* IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE) */
+
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+static void split_central_le_data_len_updated(struct bt_conn *conn,
+                                              struct bt_conn_le_data_len_info *info) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL) {
+        return;
+    }
+
+    LOG_DBG("Peripheral %d: data length tx %d rx %d", (int)(slot - peripherals), info->tx_max_len,
+            info->rx_max_len);
+    split_central_update_link_info(slot);
+}
+#endif /* IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE) */
+
 static struct bt_conn_cb conn_callbacks = {
     .connected = split_central_connected,
     .disconnected = split_central_disconnected,
+    .le_param_updated = split_central_le_param_updated,
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    .le_phy_updated = split_central_le_phy_updated,
+#endif
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    .le_data_len_updated = split_central_le_data_len_updated,
+#endif
 };
 
 K_THREAD_STACK_DEFINE(split_central_split_run_q_stack,
@@ -510,51 +1244,84 @@ K_THREAD_STACK_DEFINE(split_central_split_run_q_stack,
 
 struct k_work_q split_central_split_run_q;
 
-struct zmk_split_run_behavior_payload_wrapper {
+struct zmk_split_run_behavior_wrapper {
     uint8_t source;
-    struct zmk_split_run_behavior_payload payload;
+    struct zmk_split_run_behavior_data data;
 };
 
-K_MSGQ_DEFINE(zmk_split_central_split_run_msgq,
-              sizeof(struct zmk_split_run_behavior_payload_wrapper),
+K_MSGQ_DEFINE(zmk_split_central_split_run_msgq, sizeof(struct zmk_split_run_behavior_wrapper),
               CONFIG_ZMK_BLE_SPLIT_CENTRAL_SPLIT_RUN_QUEUE_SIZE, 4);
 
+static size_t split_run_capacity(uint8_t source) {
+    struct peripheral_slot *slot = &peripherals[source];
+    if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        return 1;
+    }
+
+    // Write without response payloads are limited to the ATT MTU less the opcode and handle.
+    size_t capacity =
+        (bt_gatt_get_mtu(slot->conn) - 3) / sizeof(struct zmk_split_run_behavior_data);
+    return CLAMP(capacity, 1, ZMK_SPLIT_RUN_BEHAVIOR_MAX);
+}
+
+static void split_run_write(uint8_t source, struct zmk_split_run_behavior_data *runs,
+                            size_t count) {
+    struct peripheral_slot *slot = &peripherals[source];
+
+    if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        LOG_ERR("Source not connected");
+        return;
+    }
+
+    if (!slot->behaviors_verified) {
+        LOG_ERR("Peripheral behaviors not verified, dropping %d behavior(s)", count);
+        return;
+    }
+
+    int err = bt_gatt_write_without_response(slot->conn, slot->run_behavior_handle, runs,
+                                             count * sizeof(runs[0]), true);
+    if (err) {
+        LOG_ERR("Failed to write the behavior characteristic (err %d)", err);
+    }
+}
+
 void split_central_split_run_callback(struct k_work *work) {
-    struct zmk_split_run_behavior_payload_wrapper payload_wrapper;
+    struct zmk_split_run_behavior_wrapper wrapper;
+    struct zmk_split_run_behavior_data runs[ZMK_SPLIT_RUN_BEHAVIOR_MAX];
+    size_t count = 0;
+    uint8_t source = 0;
 
     LOG_DBG("");
 
-    while (k_msgq_get(&zmk_split_central_split_run_msgq, &payload_wrapper, K_NO_WAIT) == 0) {
-        if (peripherals[payload_wrapper.source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
-            LOG_ERR("Source not connected");
-            continue;
+    // Pack consecutive runs for the same peripheral into one write, keeping them in order.
+    while (k_msgq_get(&zmk_split_central_split_run_msgq, &wrapper, K_NO_WAIT) == 0) {
+        if (count > 0 && (wrapper.source != source || count == split_run_capacity(source))) {
+            split_run_write(source, runs, count);
+            count = 0;
         }
 
-        int err = bt_gatt_write_without_response(
-            peripherals[payload_wrapper.source].conn,
-            peripherals[payload_wrapper.source].run_behavior_handle, &payload_wrapper.payload,
-            sizeof(struct zmk_split_run_behavior_payload), true);
+        source = wrapper.source;
+        runs[count++] = wrapper.data;
+    }
 
-        if (err) {
-            LOG_ERR("Failed to write the behavior characteristic (err %d)", err);
-        }
+    if (count > 0) {
+        split_run_write(source, runs, count);
     }
 }
 
 K_WORK_DEFINE(split_central_split_run_work, split_central_split_run_callback);
 
-static int
-split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_payload_wrapper payload_wrapper) {
+static int split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_wrapper wrapper) {
     LOG_DBG("");
 
-    int err = k_msgq_put(&zmk_split_central_split_run_msgq, &payload_wrapper, K_MSEC(100));
+    int err = k_msgq_put(&zmk_split_central_split_run_msgq, &wrapper, K_MSEC(100));
     if (err) {
         switch (err) {
         case -EAGAIN: {
             LOG_WRN("Consumer message queue full, popping first message and queueing again");
-            struct zmk_split_run_behavior_payload_wrapper discarded_report;
+            struct zmk_split_run_behavior_wrapper discarded_report;
             k_msgq_get(&zmk_split_central_split_run_msgq, &discarded_report, K_NO_WAIT);
-            return split_bt_invoke_behavior_payload(payload_wrapper);
+            return split_bt_invoke_behavior_payload(wrapper);
         }
         default:
             LOG_WRN("Failed to queue behavior to send (%d)", err);
@@ -567,31 +1334,378 @@ split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_payload_wrapper p
     return 0;
 };
 
+// Peripherals are sent our state for their indicators. Changes are coalesced into at most one write
+// every CONFIG_ZMK_SPLIT_BLE_CENTRAL_STATE_INTERVAL milliseconds.
+static int64_t central_state_sent_at;
+// Only known once the battery has been read, and never without a battery, e.g. on a dongle.
+static uint8_t central_battery = ZMK_SPLIT_CENTRAL_STATE_BATTERY_UNKNOWN;
+
+static void split_central_send_state(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(central_state_work, split_central_send_state);
+
+static void schedule_central_state() {
+    int64_t delay = central_state_sent_at + CONFIG_ZMK_SPLIT_BLE_CENTRAL_STATE_INTERVAL -
+                    k_uptime_get();
+    k_work_schedule_for_queue(&split_central_split_run_q, &central_state_work,
+                              K_MSEC(MAX(delay, 0)));
+}
+
+static void split_central_send_state(struct k_work *work) {
+    struct zmk_split_central_state state = {
+        .layers = sys_cpu_to_le32(zmk_keymap_layer_state()),
+        .endpoint = zmk_endpoints_selected(),
+        .ble_profile = zmk_ble_active_profile_index(),
+        .battery = central_battery,
+    };
+    bool retry = false;
+
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        struct peripheral_slot *slot = &peripherals[i];
+
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED || !slot->central_state_stale) {
+            continue;
+        }
+
+        int err = bt_gatt_write_without_response(slot->conn, slot->central_state_handle, &state,
+                                                 sizeof(state), true);
+        if (err) {
+            LOG_DBG("Failed to write central state to peripheral %d (err %d)", i, err);
+            retry = true;
+            continue;
+        }
+
+        slot->central_state_stale = false;
+    }
+
+    central_state_sent_at = k_uptime_get();
+
+    if (retry) {
+        schedule_central_state();
+    }
+}
+
+static void split_central_update_state(struct peripheral_slot *slot) {
+    // Peripherals running older firmware don't have the characteristic.
+    if (!slot->central_state_handle) {
+        return;
+    }
+
+    slot->central_state_stale = true;
+    schedule_central_state();
+}
+
+static int split_central_state_listener(const zmk_event_t *eh) {
+    const struct zmk_battery_state_changed *battery_ev = as_zmk_battery_state_changed(eh);
+    if (battery_ev) {
+        central_battery = battery_ev->state_of_charge;
+    }
+
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        if (peripherals[i].central_state_handle) {
+            peripherals[i].central_state_stale = true;
+        }
+    }
+
+    schedule_central_state();
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_central_state, split_central_state_listener);
+ZMK_SUBSCRIPTION(split_central_state, zmk_layer_state_changed);
+ZMK_SUBSCRIPTION(split_central_state, zmk_endpoint_selection_changed);
+ZMK_SUBSCRIPTION(split_central_state, zmk_ble_active_profile_changed);
+ZMK_SUBSCRIPTION(split_central_state, zmk_battery_state_changed);
+
+static void split_central_setup_link(struct peripheral_slot *slot) {
+    int idx = slot - peripherals;
+    int err;
+
+    slot->link_setup_done = true;
+    split_central_update_link_info(slot);
+
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    if (slot->link_stats.tx_phy != SPLIT_LINK_PHY || slot->link_stats.rx_phy != SPLIT_LINK_PHY) {
+        LOG_DBG("Requesting PHY %d for peripheral %d", SPLIT_LINK_PHY, idx);
+        err = bt_conn_le_phy_update(slot->conn, SPLIT_LINK_PHY_PARAM);
+        if (err) {
+            LOG_WRN("Failed to request the PHY for peripheral %d (err %d)", idx, err);
+        }
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_DATA_LEN_UPDATE)
+    if (slot->link_stats.tx_data_len < BT_GAP_DATA_LEN_MAX) {
+        LOG_DBG("Requesting the longest data length for peripheral %d", idx);
+        err = bt_conn_le_data_len_update(slot->conn, BT_LE_DATA_LEN_PARAM_MAX);
+        if (err) {
+            LOG_WRN("Failed to request the data length for peripheral %d (err %d)", idx, err);
+        }
+    }
+#endif
+}
+
+static void split_central_apply_link_profile(struct k_work *work) {
+    const struct bt_le_conn_param *param = split_conn_param();
+    int64_t setup_wait_ms = -1;
+
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        struct peripheral_slot *slot = &peripherals[i];
+
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+            continue;
+        }
+
+        if (slot->requested_conn_param != param) {
+            LOG_DBG("Requesting interval %d latency %d for peripheral %d", param->interval_max,
+                    param->latency, i);
+            int err = bt_conn_le_param_update(slot->conn, param);
+            if (err) {
+                LOG_WRN("Failed to request connection parameters for peripheral %d (err %d)", i,
+                        err);
+            } else {
+                slot->requested_conn_param = param;
+                slot->link_stats.requested_interval = param->interval_max;
+                slot->link_stats.requested_latency = param->latency;
+            }
+        }
+
+        if (slot->link_setup_done) {
+            continue;
+        }
+
+        int64_t wait_ms = slot->connected_at + LINK_SETUP_DELAY_MS - k_uptime_get();
+        if (wait_ms <= 0) {
+            split_central_setup_link(slot);
+        } else if (setup_wait_ms < 0 || wait_ms < setup_wait_ms) {
+            setup_wait_ms = wait_ms;
+        }
+    }
+
+    if (setup_wait_ms >= 0) {
+        k_work_schedule_for_queue(&split_central_split_run_q, k_work_delayable_from_work(work),
+                                  K_MSEC(setup_wait_ms));
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(link_profile_work, split_central_apply_link_profile);
+
+static void schedule_link_profile(k_timeout_t delay) {
+    k_work_reschedule_for_queue(&split_central_split_run_q, &link_profile_work, delay);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVITY_CONN_PARAMS)
+
+static void set_conn_params_active(bool active) {
+    if (conn_params_active == active) {
+        return;
+    }
+
+    conn_params_active = active;
+    schedule_link_profile(K_NO_WAIT);
+}
+
+static void conn_params_quiet_work_handler(struct k_work *work) { set_conn_params_active(false); }
+
+static K_WORK_DELAYABLE_DEFINE(conn_params_quiet_work, conn_params_quiet_work_handler);
+
+static int split_central_conn_params_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *activity_ev = as_zmk_activity_state_changed(eh);
+    if (activity_ev) {
+        if (activity_ev->state != ZMK_ACTIVITY_ACTIVE) {
+            k_work_cancel_delayable(&conn_params_quiet_work);
+            set_conn_params_active(false);
+        }
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    if (zmk_activity_get_state() == ZMK_ACTIVITY_ACTIVE) {
+        k_work_reschedule(&conn_params_quiet_work,
+                          K_MSEC(CONFIG_ZMK_SPLIT_BLE_CENTRAL_CONN_PARAMS_QUIET_PERIOD));
+        set_conn_params_active(true);
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_central_conn_params, split_central_conn_params_listener);
+ZMK_SUBSCRIPTION(split_central_conn_params, zmk_activity_state_changed);
+ZMK_SUBSCRIPTION(split_central_conn_params, zmk_position_state_changed);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_ACTIVITY_CONN_PARAMS) */
+
+int zmk_split_bt_get_link_stats(uint8_t source, struct zmk_split_bt_link_stats *stats) {
+    if (source >= ZMK_BLE_SPLIT_PERIPHERAL_COUNT) {
+        return -EINVAL;
+    }
+
+    if (peripherals[source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        return -ENOTCONN;
+    }
+
+    *stats = peripherals[source].link_stats;
+    return 0;
+}
+
+#if CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL > 0
+
+// The host API has no call for a connection's RSSI, so ask the controller directly.
+static int read_conn_rssi(struct bt_conn *conn, int8_t *rssi) {
+    struct bt_hci_cp_read_rssi *cp;
+    struct bt_hci_rp_read_rssi *rp;
+    struct net_buf *buf, *rsp = NULL;
+    uint16_t handle;
+
+    int err = bt_hci_get_conn_handle(conn, &handle);
+    if (err) {
+        return err;
+    }
+
+    buf = bt_hci_cmd_create(BT_HCI_OP_READ_RSSI, sizeof(*cp));
+    if (!buf) {
+        return -ENOBUFS;
+    }
+
+    cp = net_buf_add(buf, sizeof(*cp));
+    cp->handle = sys_cpu_to_le16(handle);
+
+    err = bt_hci_cmd_send_sync(BT_HCI_OP_READ_RSSI, buf, &rsp);
+    if (err) {
+        return err;
+    }
+
+    rp = (void *)rsp->data;
+    *rssi = rp->status ? ZMK_SPLIT_BT_RSSI_UNKNOWN : rp->rssi;
+    net_buf_unref(rsp);
+
+    return 0;
+}
+
+static void split_central_report_link_stats(struct k_work *work) {
+    for (int i = 0; i < ZMK_BLE_SPLIT_PERIPHERAL_COUNT; i++) {
+        struct peripheral_slot *slot = &peripherals[i];
+        struct zmk_split_bt_link_stats *stats = &slot->link_stats;
+
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+            continue;
+        }
+
+        split_central_update_link_info(slot);
+
+        int8_t rssi;
+        if (read_conn_rssi(slot->conn, &rssi) == 0) {
+            stats->rssi = rssi;
+        }
+
+        stats->delay_avg_ms = slot->delay_count > 0 ? slot->delay_sum_ms / slot->delay_count : 0;
+        stats->delay_max_ms = slot->delay_max_ms;
+        slot->delay_sum_ms = 0;
+        slot->delay_count = 0;
+        slot->delay_max_ms = 0;
+
+        LOG_INF("Peripheral %d link: RSSI %d dBm, interval %d us (requested %d us), latency %d "
+                "(requested %d), PHY %d/%d, data length %d/%d",
+                i, stats->rssi, stats->interval * 1250, stats->requested_interval * 1250,
+                stats->latency, stats->requested_latency, stats->tx_phy, stats->rx_phy,
+                stats->tx_data_len, stats->rx_data_len);
+        LOG_INF("Peripheral %d events: %d notifications, %d gaps, %d queue overflows, delay avg "
+                "%d ms max %d ms",
+                i, stats->notifications, stats->gaps, stats->queue_overflows, stats->delay_avg_ms,
+                stats->delay_max_ms);
+
+        ZMK_EVENT_RAISE(new_zmk_split_peripheral_link_changed(
+            (struct zmk_split_peripheral_link_changed){.source = i, .stats = *stats}));
+    }
+
+    k_work_schedule(k_work_delayable_from_work(work),
+                    K_SECONDS(CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL));
+}
+
+// Runs on the system work queue, next to the position event work that collects the delays. Reading
+// the RSSI waits on the controller, which mustn't hold up behavior and central state writes on the
+// split run queue.
+static K_WORK_DELAYABLE_DEFINE(link_stats_work, split_central_report_link_stats);
+
+#endif /* CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL > 0 */
+
 int zmk_split_bt_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
                                  struct zmk_behavior_binding_event event, bool state) {
-    struct zmk_split_run_behavior_payload payload = {.data = {
-                                                         .param1 = binding->param1,
-                                                         .param2 = binding->param2,
-                                                         .position = event.position,
-                                                         .state = state ? 1 : 0,
-                                                     }};
-    const size_t payload_dev_size = sizeof(payload.behavior_dev);
-    if (strlcpy(payload.behavior_dev, binding->behavior_dev, payload_dev_size) >=
-        payload_dev_size) {
-        LOG_ERR("Truncated behavior label %s to %s before invoking peripheral behavior",
-                log_strdup(binding->behavior_dev), log_strdup(payload.behavior_dev));
-    }
-
-    struct zmk_split_run_behavior_payload_wrapper wrapper = {.source = source, .payload = payload};
+    int behavior_id = zmk_split_behavior_id(binding->behavior_dev);
+    if (behavior_id < 0) {
+        LOG_ERR("Behavior %s can't be invoked on peripherals", log_strdup(binding->behavior_dev));
+        return behavior_id;
+    }
+
+    struct zmk_split_run_behavior_wrapper wrapper = {
+        .source = source,
+        .data =
+            {
+                .behavior_id = behavior_id,
+                .state = state ? 1 : 0,
+                .position = sys_cpu_to_le16(event.position),
+                .param1 = sys_cpu_to_le32(binding->param1),
+                .param2 = sys_cpu_to_le32(binding->param2),
+            },
+    };
     return split_bt_invoke_behavior_payload(wrapper);
 }
 
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+static int split_central_handle_set(const char *name, size_t len, settings_read_cb read_cb,
+                                    void *cb_arg) {
+    const char *next;
+
+    if (settings_name_steq(name, "handles", &next) && next) {
+        char *endptr;
+        uint8_t idx = strtoul(next, &endptr, 10);
+        if (*endptr != '\0' || idx >= ARRAY_SIZE(handle_caches)) {
+            LOG_WRN("Invalid handle cache index: %s", log_strdup(next));
+            return -EINVAL;
+        }
+
+        if (len != sizeof(struct peripheral_handle_cache)) {
+            return -EINVAL;
+        }
+
+        int err = read_cb(cb_arg, &handle_caches[idx], sizeof(struct peripheral_handle_cache));
+        if (err <= 0) {
+            LOG_ERR("Failed to handle peripheral handle cache from settings (err %d)", err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+struct settings_handler split_central_handler = {.name = "split/central",
+                                                 .h_set = split_central_handle_set};
+
+#endif /* IS_ENABLED(CONFIG_SETTINGS) */
+
 int zmk_split_bt_central_init(const struct device *_arg) {
+#if IS_ENABLED(CONFIG_SETTINGS)
+    settings_subsys_init();
+
+    int err = settings_register(&split_central_handler);
+    if (err) {
+        LOG_ERR("Failed to register the split central settings handler (err %d)", err);
+        return err;
+    }
+
+    settings_load_subtree("split/central");
+#endif
+
     k_work_queue_start(&split_central_split_run_q, split_central_split_run_q_stack,
                        K_THREAD_STACK_SIZEOF(split_central_split_run_q_stack),
                        CONFIG_ZMK_BLE_THREAD_PRIORITY, NULL);
     bt_conn_cb_register(&conn_callbacks);
 
+#if CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL > 0
+    k_work_schedule(&link_stats_work, K_SECONDS(CONFIG_ZMK_SPLIT_BLE_CENTRAL_LINK_STATS_INTERVAL));
+#endif
+
     return start_scan();
 }
 
@@ -5,6 +5,7 @@
  */
 
 #include <zephyr/types.h>
+#include <sys/byteorder.h>
 #include <sys/util.h>
 #include <init.h>
 
@@ -15,140 +16,258 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <bluetooth/gatt.h>
 #include <bluetooth/uuid.h>
 
-#include <drivers/behavior.h>
-#include <zmk/behavior.h>
 #include <zmk/matrix.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/split_central_state_changed.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
 
-#define POS_STATE_LEN 16
+#define POSITION_EVENT_QUEUE_SIZE CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE
 
-static uint8_t num_of_positions = ZMK_KEYMAP_LEN;
-static uint8_t position_state[POS_STATE_LEN];
+// The central compares sequence numbers as signed 8 bit offsets.
+BUILD_ASSERT(POSITION_EVENT_QUEUE_SIZE < 128,
+             "Position queue size must be less than 128 for sequence numbers to stay unambiguous");
 
-static struct zmk_split_run_behavior_payload behavior_run_payload;
+BUILD_ASSERT(ZMK_KEYMAP_LEN <= ZMK_SPLIT_POSITION_MAX + 1, "Too many key positions to split");
+
+#define POSITION_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
+// The descriptor is only a single byte, so the snapshot carries the full count.
+static uint8_t num_of_positions = MIN(ZMK_KEYMAP_LEN, UINT8_MAX);
+static uint8_t position_state[POSITION_STATE_LEN];
+
+// Events that haven't been notified yet. The oldest one has sequence number
+// next_sequence - position_event_count.
+static struct zmk_split_position_event position_events[POSITION_EVENT_QUEUE_SIZE];
+static uint32_t position_event_times[POSITION_EVENT_QUEUE_SIZE];
+static size_t position_event_head;
+static size_t position_event_count;
+static uint8_t next_sequence;
+static struct k_spinlock position_lock;
+
+static struct zmk_split_central_state_changed central_state;
+static struct k_spinlock central_state_lock;
+
+K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
+
+struct k_work_q service_work_q;
 
 static ssize_t split_svc_pos_state(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                    void *buf, uint16_t len, uint16_t offset) {
-    return bt_gatt_attr_read(conn, attrs, buf, len, offset, &position_state,
-                             sizeof(position_state));
+    static uint8_t snapshot_data[sizeof(struct zmk_split_position_snapshot) + POSITION_STATE_LEN];
+    struct zmk_split_position_snapshot *snapshot = (void *)snapshot_data;
+
+    // The rest of a long read has to come from the same snapshot, or the sequence number wouldn't
+    // match the state.
+    if (offset == 0) {
+        k_spinlock_key_t key = k_spin_lock(&position_lock);
+        snapshot->sequence = next_sequence;
+        snapshot->position_count = sys_cpu_to_le16(ZMK_KEYMAP_LEN);
+        memcpy(snapshot->position_state, position_state, sizeof(position_state));
+        k_spin_unlock(&position_lock, key);
+    }
+
+    return bt_gatt_attr_read(conn, attrs, buf, len, offset, snapshot_data, sizeof(snapshot_data));
+}
+
+static ssize_t split_svc_pos_events(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
+                                    void *buf, uint16_t len, uint16_t offset) {
+    // Events are only meaningful as notifications, so reads get an empty batch.
+    uint8_t sequence = next_sequence;
+    return bt_gatt_attr_read(conn, attrs, buf, len, offset, &sequence, sizeof(sequence));
 }
 
 static ssize_t split_svc_run_behavior(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                       const void *buf, uint16_t len, uint16_t offset,
                                       uint8_t flags) {
-    struct zmk_split_run_behavior_payload *payload = attrs->user_data;
-    uint16_t end_addr = offset + len;
+    const struct zmk_split_run_behavior_data *runs = buf;
 
     LOG_DBG("offset %d len %d", offset, len);
 
-    if (end_addr > sizeof(struct zmk_split_run_behavior_payload)) {
+    if (offset != 0) {
         return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
     }
 
-    memcpy(payload + offset, buf, len);
-
-    // We run if:
-    // 1: We've gotten all the position/state/param data.
-    // 2: We have a null terminated string for the behavior device label.
-    const size_t behavior_dev_offset =
-        offsetof(struct zmk_split_run_behavior_payload, behavior_dev);
-    if ((end_addr > sizeof(struct zmk_split_run_behavior_data)) &&
-        payload->behavior_dev[end_addr - behavior_dev_offset - 1] == '\0') {
-        struct zmk_behavior_binding binding = {
-            .param1 = payload->data.param1,
-            .param2 = payload->data.param2,
-            .behavior_dev = payload->behavior_dev,
-        };
-        LOG_DBG("%s with params %d %d: pressed? %d", log_strdup(binding.behavior_dev),
-                binding.param1, binding.param2, payload->data.state);
-        struct zmk_behavior_binding_event event = {.position = payload->data.position,
-                                                   .timestamp = k_uptime_get()};
-        int err;
-        if (payload->data.state > 0) {
-            err = behavior_keymap_binding_pressed(&binding, event);
-        } else {
-            err = behavior_keymap_binding_released(&binding, event);
-        }
-
-        if (err) {
-            LOG_ERR("Failed to invoke behavior %s: %d", log_strdup(binding.behavior_dev), err);
-        }
+    if (len % sizeof(runs[0]) != 0 || len / sizeof(runs[0]) > ZMK_SPLIT_RUN_BEHAVIOR_MAX) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    for (int i = 0; i < len / sizeof(runs[0]); i++) {
+        const struct zmk_split_run_behavior_data *run = &runs[i];
+
+        zmk_split_behavior_run(run->behavior_id, sys_le32_to_cpu(run->param1),
+                               sys_le32_to_cpu(run->param2), sys_le16_to_cpu(run->position),
+                               run->state > 0);
     }
 
     return len;
 }
 
+static void raise_central_state_changed(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&central_state_lock);
+    struct zmk_split_central_state_changed ev = central_state;
+    k_spin_unlock(&central_state_lock, key);
+
+    ZMK_EVENT_RAISE(new_zmk_split_central_state_changed(ev));
+}
+
+static K_WORK_DEFINE(central_state_work, raise_central_state_changed);
+
+static ssize_t split_svc_central_state(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
+                                       const void *buf, uint16_t len, uint16_t offset,
+                                       uint8_t flags) {
+    struct zmk_split_central_state state = {.battery = ZMK_SPLIT_CENTRAL_STATE_BATTERY_UNKNOWN};
+
+    if (offset != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    // A central with fewer fields leaves the rest at their defaults.
+    memcpy(&state, buf, MIN(len, sizeof(state)));
+
+    k_spinlock_key_t key = k_spin_lock(&central_state_lock);
+    central_state = (struct zmk_split_central_state_changed){
+        .layers = sys_le32_to_cpu(state.layers),
+        .endpoint = state.endpoint,
+        .ble_profile = state.ble_profile,
+        .battery = state.battery,
+    };
+    k_spin_unlock(&central_state_lock, key);
+
+    k_work_submit_to_queue(&service_work_q, &central_state_work);
+
+    return len;
+}
+
+static ssize_t split_svc_behaviors_hash(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
+                                        void *buf, uint16_t len, uint16_t offset) {
+    uint32_t hash = sys_cpu_to_le32(zmk_split_behaviors_hash());
+    return bt_gatt_attr_read(conn, attrs, buf, len, offset, &hash, sizeof(hash));
+}
+
 static ssize_t split_svc_num_of_positions(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                           void *buf, uint16_t len, uint16_t offset) {
     return bt_gatt_attr_read(conn, attrs, buf, len, offset, attrs->user_data, sizeof(uint8_t));
 }
 
-static void split_svc_pos_state_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+static void split_svc_pos_events_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
     LOG_DBG("value %d", value);
 }
 
 BT_GATT_SERVICE_DEFINE(
     split_svc, BT_GATT_PRIMARY_SERVICE(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_SERVICE_UUID)),
     BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID),
+                           BT_GATT_CHRC_READ, BT_GATT_PERM_READ_ENCRYPT, split_svc_pos_state, NULL,
+                           NULL),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID),
                            BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ_ENCRYPT,
-                           split_svc_pos_state, NULL, &position_state),
-    BT_GATT_CCC(split_svc_pos_state_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
-    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID),
+                           split_svc_pos_events, NULL, NULL),
+    BT_GATT_CCC(split_svc_pos_events_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_CENTRAL_STATE_UUID),
                            BT_GATT_CHRC_WRITE_WITHOUT_RESP, BT_GATT_PERM_WRITE_ENCRYPT, NULL,
-                           split_svc_run_behavior, &behavior_run_payload),
+                           split_svc_central_state, NULL),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID),
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                           BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT,
+                           split_svc_behaviors_hash, split_svc_run_behavior, NULL),
     BT_GATT_DESCRIPTOR(BT_UUID_NUM_OF_DIGITALS, BT_GATT_PERM_READ, split_svc_num_of_positions, NULL,
                        &num_of_positions), );
 
-K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
+// Retried after this long when the controller has no buffers left for the notification.
+#define NOTIFY_RETRY_DELAY K_MSEC(5)
 
-struct k_work_q service_work_q;
+static void send_position_events_callback(struct k_work *work) {
+    struct zmk_split_position_events batch;
+    size_t count;
 
-K_MSGQ_DEFINE(position_state_msgq, sizeof(char[POS_STATE_LEN]),
-              CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
+    uint32_t now = k_uptime_get_32();
+    batch.timestamp = sys_cpu_to_le16(now);
 
-void send_position_state_callback(struct k_work *work) {
-    uint8_t state[POS_STATE_LEN];
+    k_spinlock_key_t key = k_spin_lock(&position_lock);
+    count = MIN(position_event_count, ZMK_SPLIT_POSITION_EVENTS_MAX);
+    batch.sequence = next_sequence - position_event_count;
+    for (int i = 0; i < count; i++) {
+        size_t index = (position_event_head + i) % POSITION_EVENT_QUEUE_SIZE;
+        batch.events[i] = position_events[index];
+        batch.events[i].age = MIN(now - position_event_times[index], UINT8_MAX);
+    }
+    k_spin_unlock(&position_lock, key);
 
-    while (k_msgq_get(&position_state_msgq, &state, K_NO_WAIT) == 0) {
-        int err = bt_gatt_notify(NULL, &split_svc.attrs[1], &state, sizeof(state));
-        if (err) {
-            LOG_DBG("Error notifying %d", err);
-        }
+    if (count == 0) {
+        return;
     }
-};
 
-K_WORK_DEFINE(service_position_notify_work, send_position_state_callback);
+    int err = bt_gatt_notify(NULL, &split_svc.attrs[3], &batch,
+                             offsetof(struct zmk_split_position_events, events) +
+                                 count * sizeof(batch.events[0]));
+    if (err == -ENOMEM) {
+        k_work_schedule_for_queue(&service_work_q, k_work_delayable_from_work(work),
+                                  NOTIFY_RETRY_DELAY);
+        return;
+    }
 
-int send_position_state() {
-    int err = k_msgq_put(&position_state_msgq, position_state, K_MSEC(100));
     if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Position state message queue full, popping first message and queueing again");
-            uint8_t discarded_state[POS_STATE_LEN];
-            k_msgq_get(&position_state_msgq, &discarded_state, K_NO_WAIT);
-            return send_position_state();
-        }
-        default:
-            LOG_WRN("Failed to queue position state to send (%d)", err);
-            return err;
-        }
+        // Most likely nothing is subscribed. The central resynchronizes from the position state
+        // when it next subscribes, so there's no point holding on to the events.
+        LOG_DBG("Error notifying %d", err);
     }
 
-    k_work_submit_to_queue(&service_work_q, &service_position_notify_work);
+    key = k_spin_lock(&position_lock);
+    // Events may have been dropped from the queue while notifying, so only remove what's left of
+    // the batch.
+    uint8_t oldest = next_sequence - position_event_count;
+    int8_t sent = batch.sequence + count - oldest;
+    sent = CLAMP(sent, 0, (int)position_event_count);
+    position_event_head = (position_event_head + sent) % POSITION_EVENT_QUEUE_SIZE;
+    position_event_count -= sent;
+    bool more = position_event_count > 0;
+    k_spin_unlock(&position_lock, key);
+
+    if (more) {
+        k_work_schedule_for_queue(&service_work_q, k_work_delayable_from_work(work), K_NO_WAIT);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(service_position_notify_work, send_position_events_callback);
+
+static int queue_position_event(uint32_t position, bool pressed, int64_t timestamp) {
+    if (position >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&position_lock);
+
+    WRITE_BIT(position_state[position / 8], position % 8, pressed);
+
+    if (position_event_count == POSITION_EVENT_QUEUE_SIZE) {
+        // The central sees the gap in sequence numbers and resynchronizes from position_state.
+        LOG_WRN("Position event queue full, dropping the oldest event");
+        position_event_head = (position_event_head + 1) % POSITION_EVENT_QUEUE_SIZE;
+        position_event_count--;
+    }
+
+    size_t index = (position_event_head + position_event_count) % POSITION_EVENT_QUEUE_SIZE;
+    position_events[index] = (struct zmk_split_position_event){
+        .position_state =
+            sys_cpu_to_le16(position | (pressed ? ZMK_SPLIT_POSITION_EVENT_PRESSED : 0)),
+    };
+    position_event_times[index] = timestamp;
+    position_event_count++;
+    next_sequence++;
+
+    k_spin_unlock(&position_lock, key);
+
+    k_work_schedule_for_queue(&service_work_q, &service_position_notify_work, K_NO_WAIT);
 
     return 0;
 }
 
-int zmk_split_bt_position_pressed(uint8_t position) {
-    WRITE_BIT(position_state[position / 8], position % 8, true);
-    return send_position_state();
+int zmk_split_bt_position_pressed(uint32_t position, int64_t timestamp) {
+    return queue_position_event(position, true, timestamp);
 }
 
-int zmk_split_bt_position_released(uint8_t position) {
-    WRITE_BIT(position_state[position / 8], position % 8, false);
-    return send_position_state();
+int zmk_split_bt_position_released(uint32_t position, int64_t timestamp) {
+    return queue_position_event(position, false, timestamp);
 }
 
 int service_init(const struct device *_arg) {
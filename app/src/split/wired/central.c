@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <device.h>
+#include <init.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <sys/util.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/behavior.h>
+#include <zmk/matrix.h>
+#include <zmk/latency.h>
+#include <zmk/split/behaviors.h>
+#include <zmk/split/wired/central.h>
+#include <zmk/split/wired/transport.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+
+// There's only the one peripheral on the other end of the cable, which takes the same source as the
+// first BLE peripheral would.
+#define PERIPHERAL_SOURCE 0
+
+#define POSITION_STATE_DATA_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
+#define SYNC_RETRY_DELAY K_MSEC(100)
+
+static uint8_t position_state[POSITION_STATE_DATA_LEN];
+static uint8_t next_sequence;
+static bool synced;
+static bool behaviors_verified;
+static int64_t last_frame_at;
+
+static void raise_position_change(uint32_t position, bool pressed) {
+    struct zmk_position_state_changed ev = {.source = PERIPHERAL_SOURCE,
+                                            .position = position,
+                                            .state = pressed,
+                                            .timestamp = k_uptime_get()};
+
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    zmk_latency_transition_detected(ev.source, ev.timestamp, k_uptime_ticks());
+#endif
+
+    WRITE_BIT(position_state[position / 8], position % 8, pressed);
+
+    LOG_DBG("Trigger key position state change for %d", position);
+    ZMK_EVENT_RAISE(new_zmk_position_state_changed(ev));
+}
+
+static void release_all_positions() {
+    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
+        for (int j = 0; j < 8; j++) {
+            if (position_state[i] & BIT(j)) {
+                raise_position_change((i * 8) + j, false);
+            }
+        }
+    }
+}
+
+static void sync_work_callback(struct k_work *work) {
+    if (synced && k_uptime_get() - last_frame_at > ZMK_SPLIT_WIRED_LINK_TIMEOUT_MS) {
+        LOG_WRN("Lost the split peripheral");
+        synced = false;
+        release_all_positions();
+    }
+
+    zmk_split_wired_send(ZMK_SPLIT_WIRED_FRAME_SYNC_REQUEST, NULL, 0);
+
+    k_work_schedule(k_work_delayable_from_work(work),
+                    synced ? K_MSEC(ZMK_SPLIT_WIRED_KEEPALIVE_MS) : SYNC_RETRY_DELAY);
+}
+
+static K_WORK_DELAYABLE_DEFINE(sync_work, sync_work_callback);
+
+static void handle_snapshot(const uint8_t *payload, size_t len) {
+    const struct zmk_split_wired_snapshot *snapshot = (const void *)payload;
+
+    if (len < sizeof(*snapshot)) {
+        LOG_WRN("Snapshot too short (%d bytes)", len);
+        return;
+    }
+
+    uint32_t hash = sys_le32_to_cpu(snapshot->behaviors_hash);
+    behaviors_verified = hash == zmk_split_behaviors_hash();
+    if (!behaviors_verified) {
+        LOG_ERR("Peripheral behaviors (hash 0x%08x) don't match ours (0x%08x), so they won't be "
+                "run there. Flash both halves with the same firmware.",
+                hash, zmk_split_behaviors_hash());
+    }
+
+    size_t state_len = MIN(DIV_ROUND_UP(sys_le16_to_cpu(snapshot->position_count), 8),
+                           len - sizeof(*snapshot));
+
+    // Raise the difference from what we last knew, as if the events had come through.
+    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
+        uint8_t peripheral_state = i < state_len ? snapshot->position_state[i] : 0;
+        uint8_t changed = position_state[i] ^ peripheral_state;
+
+        for (int j = 0; j < 8; j++) {
+            if (changed & BIT(j)) {
+                raise_position_change((i * 8) + j, peripheral_state & BIT(j));
+            }
+        }
+    }
+
+    if (!synced) {
+        LOG_INF("Synchronized with the split peripheral");
+    }
+
+    next_sequence = snapshot->sequence;
+    synced = true;
+}
+
+static void handle_position_event(const uint8_t *payload, size_t len) {
+    const struct zmk_split_wired_position_event *event = (const void *)payload;
+
+    if (len != sizeof(*event) || !synced) {
+        return;
+    }
+
+    if (event->sequence != next_sequence) {
+        LOG_WRN("Expected position event %d but got %d, resynchronizing", next_sequence,
+                event->sequence);
+        synced = false;
+        k_work_reschedule(&sync_work, K_NO_WAIT);
+        return;
+    }
+
+    next_sequence++;
+
+    uint16_t position_state = sys_le16_to_cpu(event->position_state);
+    uint32_t position = position_state & ZMK_SPLIT_WIRED_POSITION_MAX;
+    if (position >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Peripheral position %d is out of range", position);
+        return;
+    }
+
+    raise_position_change(position, position_state & ZMK_SPLIT_WIRED_POSITION_EVENT_PRESSED);
+}
+
+void zmk_split_wired_handle_frame(uint8_t type, const uint8_t *payload, size_t len) {
+    last_frame_at = k_uptime_get();
+
+    switch (type) {
+    case ZMK_SPLIT_WIRED_FRAME_SNAPSHOT:
+        handle_snapshot(payload, len);
+        break;
+    case ZMK_SPLIT_WIRED_FRAME_POSITION_EVENT:
+        handle_position_event(payload, len);
+        break;
+    default:
+        LOG_WRN("Unexpected frame type 0x%02x", type);
+        break;
+    }
+}
+
+int zmk_split_wired_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                                    struct zmk_behavior_binding_event event, bool state) {
+    int behavior_id = zmk_split_behavior_id(binding->behavior_dev);
+    if (behavior_id < 0) {
+        LOG_ERR("Behavior %s can't be invoked on peripherals", log_strdup(binding->behavior_dev));
+        return behavior_id;
+    }
+
+    if (!behaviors_verified) {
+        return -ENOTCONN;
+    }
+
+    struct zmk_split_wired_run_behavior run = {
+        .behavior_id = behavior_id,
+        .state = state ? 1 : 0,
+        .position = sys_cpu_to_le16(event.position),
+        .param1 = sys_cpu_to_le32(binding->param1),
+        .param2 = sys_cpu_to_le32(binding->param2),
+    };
+
+    return zmk_split_wired_send(ZMK_SPLIT_WIRED_FRAME_RUN_BEHAVIOR, &run, sizeof(run));
+}
+
+static int split_wired_central_init(const struct device *_arg) {
+    k_work_schedule(&sync_work, K_NO_WAIT);
+    return 0;
+}
+
+SYS_INIT(split_wired_central_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
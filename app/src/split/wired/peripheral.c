@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <device.h>
+#include <init.h>
+#include <kernel.h>
+#include <string.h>
+#include <sys/byteorder.h>
+#include <sys/util.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/matrix.h>
+#include <zmk/split/behaviors.h>
+#include <zmk/split/wired/transport.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/split_peripheral_status_changed.h>
+
+BUILD_ASSERT(ZMK_KEYMAP_LEN <= ZMK_SPLIT_WIRED_POSITION_MAX + 1, "Too many key positions to split");
+
+#define POSITION_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
+BUILD_ASSERT(sizeof(struct zmk_split_wired_snapshot) + POSITION_STATE_LEN <=
+                 ZMK_SPLIT_WIRED_PAYLOAD_MAX,
+             "Too many key positions for a wired split snapshot");
+
+static uint8_t position_state[POSITION_STATE_LEN];
+static uint8_t next_sequence;
+// Keeps the sequence numbers in the order frames go out on the wire.
+static K_MUTEX_DEFINE(position_mutex);
+
+static bool is_connected = false;
+
+static void send_snapshot() {
+    uint8_t data[sizeof(struct zmk_split_wired_snapshot) + POSITION_STATE_LEN];
+    struct zmk_split_wired_snapshot *snapshot = (void *)data;
+
+    k_mutex_lock(&position_mutex, K_FOREVER);
+    snapshot->behaviors_hash = sys_cpu_to_le32(zmk_split_behaviors_hash());
+    snapshot->sequence = next_sequence;
+    snapshot->position_count = sys_cpu_to_le16(ZMK_KEYMAP_LEN);
+    memcpy(snapshot->position_state, position_state, sizeof(position_state));
+    int err = zmk_split_wired_send(ZMK_SPLIT_WIRED_FRAME_SNAPSHOT, data, sizeof(data));
+    k_mutex_unlock(&position_mutex);
+
+    if (err) {
+        LOG_ERR("Failed to send snapshot (err %d)", err);
+    }
+}
+
+static void set_connected(bool connected) {
+    if (is_connected == connected) {
+        return;
+    }
+
+    is_connected = connected;
+
+    ZMK_EVENT_RAISE(new_zmk_split_peripheral_status_changed(
+        (struct zmk_split_peripheral_status_changed){.connected = is_connected}));
+}
+
+static void link_timeout_callback(struct k_work *work) {
+    LOG_WRN("Lost the split central");
+    set_connected(false);
+}
+
+static K_WORK_DELAYABLE_DEFINE(link_timeout_work, link_timeout_callback);
+
+static void handle_run_behavior(const uint8_t *payload, size_t len) {
+    const struct zmk_split_wired_run_behavior *run = (const void *)payload;
+
+    if (len != sizeof(*run)) {
+        LOG_WRN("Run behavior frame has the wrong length (%d bytes)", len);
+        return;
+    }
+
+    zmk_split_behavior_run(run->behavior_id, sys_le32_to_cpu(run->param1),
+                           sys_le32_to_cpu(run->param2), sys_le16_to_cpu(run->position),
+                           run->state > 0);
+}
+
+void zmk_split_wired_handle_frame(uint8_t type, const uint8_t *payload, size_t len) {
+    k_work_reschedule(&link_timeout_work, K_MSEC(ZMK_SPLIT_WIRED_LINK_TIMEOUT_MS));
+    set_connected(true);
+
+    switch (type) {
+    case ZMK_SPLIT_WIRED_FRAME_SYNC_REQUEST:
+        send_snapshot();
+        break;
+    case ZMK_SPLIT_WIRED_FRAME_RUN_BEHAVIOR:
+        handle_run_behavior(payload, len);
+        break;
+    default:
+        LOG_WRN("Unexpected frame type 0x%02x", type);
+        break;
+    }
+}
+
+int split_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *ev = as_zmk_position_state_changed(eh);
+    if (ev == NULL || ev->position >= ZMK_KEYMAP_LEN) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    k_mutex_lock(&position_mutex, K_FOREVER);
+    WRITE_BIT(position_state[ev->position / 8], ev->position % 8, ev->state);
+
+    struct zmk_split_wired_position_event event = {
+        .sequence = next_sequence++,
+        .position_state = sys_cpu_to_le16(
+            ev->position | (ev->state ? ZMK_SPLIT_WIRED_POSITION_EVENT_PRESSED : 0)),
+    };
+    LOG_DBG("Position %d %s, sequence %d", ev->position, ev->state ? "pressed" : "released",
+            event.sequence);
+
+    // A lost event leaves a gap in the sequence numbers, which the central recovers from.
+    int err = zmk_split_wired_send(ZMK_SPLIT_WIRED_FRAME_POSITION_EVENT, &event, sizeof(event));
+    k_mutex_unlock(&position_mutex);
+
+    if (err) {
+        LOG_WRN("Failed to send position event (err %d)", err);
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_listener, split_listener);
+ZMK_SUBSCRIPTION(split_listener, zmk_position_state_changed);
+
+// Lets a central that's already running pick up a peripheral that has just restarted, without
+// waiting for its next keepalive.
+static void initial_snapshot_callback(struct k_work *work) { send_snapshot(); }
+
+static K_WORK_DEFINE(initial_snapshot_work, initial_snapshot_callback);
+
+static int split_wired_peripheral_init(const struct device *_arg) {
+    k_work_submit(&initial_snapshot_work);
+    return 0;
+}
+
+SYS_INIT(split_wired_peripheral_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
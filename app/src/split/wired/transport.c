@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <device.h>
+#include <init.h>
+#include <kernel.h>
+#include <string.h>
+#include <drivers/uart.h>
+#include <sys/byteorder.h>
+#include <sys/crc.h>
+#include <sys/ring_buffer.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/split/wired/transport.h>
+
+BUILD_ASSERT(DT_HAS_CHOSEN(zmk_split_uart),
+             "The wired split transport needs a zmk,split-uart chosen node");
+
+static const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(zmk_split_uart));
+
+#define CRC_SEED 0xFFFF
+
+static uint8_t rx_frame[ZMK_SPLIT_WIRED_FRAME_MAX];
+static size_t rx_frame_len;
+
+static bool is_known_frame_type(uint8_t type) {
+    switch (type) {
+    case ZMK_SPLIT_WIRED_FRAME_POSITION_EVENT:
+    case ZMK_SPLIT_WIRED_FRAME_SNAPSHOT:
+    case ZMK_SPLIT_WIRED_FRAME_SYNC_REQUEST:
+    case ZMK_SPLIT_WIRED_FRAME_RUN_BEHAVIOR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void discard_rx_bytes(size_t count) {
+    memmove(rx_frame, rx_frame + count, rx_frame_len - count);
+    rx_frame_len -= count;
+}
+
+static void process_rx_frame() {
+    while (rx_frame_len > 0) {
+        if (rx_frame[0] != ZMK_SPLIT_WIRED_FRAME_START) {
+            discard_rx_bytes(1);
+            continue;
+        }
+
+        if (rx_frame_len < ZMK_SPLIT_WIRED_FRAME_HEADER_LEN) {
+            return;
+        }
+
+        // Rejecting unknown types early keeps a stray start byte from holding up the frames after
+        // it until a whole bogus payload has arrived.
+        if (!is_known_frame_type(rx_frame[1])) {
+            discard_rx_bytes(1);
+            continue;
+        }
+
+        uint8_t payload_len = rx_frame[2];
+        size_t frame_len =
+            ZMK_SPLIT_WIRED_FRAME_HEADER_LEN + payload_len + ZMK_SPLIT_WIRED_FRAME_CRC_LEN;
+        if (rx_frame_len < frame_len) {
+            return;
+        }
+
+        uint16_t crc = crc16_ccitt(CRC_SEED, &rx_frame[1], 2 + payload_len);
+        if (crc != sys_get_le16(&rx_frame[ZMK_SPLIT_WIRED_FRAME_HEADER_LEN + payload_len])) {
+            LOG_WRN("Discarding frame type 0x%02x with bad CRC", rx_frame[1]);
+            discard_rx_bytes(1);
+            continue;
+        }
+
+        zmk_split_wired_handle_frame(rx_frame[1], &rx_frame[ZMK_SPLIT_WIRED_FRAME_HEADER_LEN],
+                                     payload_len);
+        discard_rx_bytes(frame_len);
+    }
+}
+
+static void process_rx_bytes(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        rx_frame[rx_frame_len++] = data[i];
+        process_rx_frame();
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC)
+
+// Received bytes are handed from the UART callback to the system work queue through rx_buf, and
+// frames to send are queued in tx_buf until the UART is done with the previous chunk.
+#define RX_CHUNK_SIZE 32
+#define RX_TIMEOUT_US 100
+
+RING_BUF_DECLARE(rx_buf, CONFIG_ZMK_SPLIT_WIRED_RX_BUFFER_SIZE);
+RING_BUF_DECLARE(tx_buf, CONFIG_ZMK_SPLIT_WIRED_TX_BUFFER_SIZE);
+
+static uint8_t rx_chunks[2][RX_CHUNK_SIZE];
+static uint8_t next_rx_chunk;
+
+static bool tx_busy;
+static struct k_spinlock tx_lock;
+
+static void rx_work_callback(struct k_work *work) {
+    uint8_t data[RX_CHUNK_SIZE];
+    size_t len;
+
+    while ((len = ring_buf_get(&rx_buf, data, sizeof(data))) > 0) {
+        process_rx_bytes(data, len);
+    }
+}
+
+static K_WORK_DEFINE(rx_work, rx_work_callback);
+
+static void start_tx() {
+    uint8_t *data;
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    if (tx_busy) {
+        k_spin_unlock(&tx_lock, key);
+        return;
+    }
+
+    size_t len = ring_buf_get_claim(&tx_buf, &data, CONFIG_ZMK_SPLIT_WIRED_TX_BUFFER_SIZE);
+    tx_busy = len > 0;
+    k_spin_unlock(&tx_lock, key);
+
+    if (len == 0) {
+        return;
+    }
+
+    int err = uart_tx(uart, data, len, SYS_FOREVER_US);
+    if (err) {
+        // Whatever was cut short fails its CRC on the other half.
+        LOG_ERR("Failed to start UART transmit (err %d)", err);
+        key = k_spin_lock(&tx_lock);
+        ring_buf_get_finish(&tx_buf, len);
+        tx_busy = false;
+        k_spin_unlock(&tx_lock, key);
+    }
+}
+
+static int start_rx() {
+    next_rx_chunk = 1;
+    return uart_rx_enable(uart, rx_chunks[0], sizeof(rx_chunks[0]), RX_TIMEOUT_US);
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data) {
+    k_spinlock_key_t key;
+
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        key = k_spin_lock(&tx_lock);
+        ring_buf_get_finish(&tx_buf, evt->data.tx.len);
+        tx_busy = false;
+        k_spin_unlock(&tx_lock, key);
+        start_tx();
+        break;
+    case UART_RX_RDY:
+        if (ring_buf_put(&rx_buf, evt->data.rx.buf + evt->data.rx.offset, evt->data.rx.len) <
+            evt->data.rx.len) {
+            LOG_WRN("Receive buffer full, dropping bytes");
+        }
+        k_work_submit(&rx_work);
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, rx_chunks[next_rx_chunk], sizeof(rx_chunks[0]));
+        next_rx_chunk ^= 1;
+        break;
+    case UART_RX_STOPPED:
+        LOG_WRN("UART receive stopped (reason %d)", evt->data.rx_stop.reason);
+        break;
+    case UART_RX_DISABLED:
+        start_rx();
+        break;
+    default:
+        break;
+    }
+}
+
+#else
+
+static void poll_work_callback(struct k_work *work) {
+    uint8_t data[32];
+    size_t len = 0;
+
+    while (len < sizeof(data) && uart_poll_in(uart, &data[len]) == 0) {
+        len++;
+    }
+
+    process_rx_bytes(data, len);
+
+    k_work_schedule(k_work_delayable_from_work(work),
+                    K_MSEC(len == sizeof(data) ? 0 : CONFIG_ZMK_SPLIT_WIRED_POLL_INTERVAL));
+}
+
+static K_WORK_DELAYABLE_DEFINE(poll_work, poll_work_callback);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC) */
+
+int zmk_split_wired_send(uint8_t type, const void *payload, size_t len) {
+    if (len > ZMK_SPLIT_WIRED_PAYLOAD_MAX) {
+        return -EINVAL;
+    }
+
+    uint8_t header[ZMK_SPLIT_WIRED_FRAME_HEADER_LEN] = {ZMK_SPLIT_WIRED_FRAME_START, type, len};
+    uint8_t trailer[ZMK_SPLIT_WIRED_FRAME_CRC_LEN];
+
+    uint16_t crc = crc16_ccitt(CRC_SEED, &header[1], 2);
+    crc = crc16_ccitt(crc, payload, len);
+    sys_put_le16(crc, trailer);
+
+    LOG_DBG("Sending frame type 0x%02x, %d bytes, crc 0x%04x", type, len, crc);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC)
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    if (ring_buf_space_get(&tx_buf) < sizeof(header) + len + sizeof(trailer)) {
+        k_spin_unlock(&tx_lock, key);
+        LOG_WRN("Transmit buffer full, dropping frame type 0x%02x", type);
+        return -ENOMEM;
+    }
+
+    ring_buf_put(&tx_buf, header, sizeof(header));
+    ring_buf_put(&tx_buf, payload, len);
+    ring_buf_put(&tx_buf, trailer, sizeof(trailer));
+    k_spin_unlock(&tx_lock, key);
+
+    start_tx();
+#else
+    const uint8_t *data = payload;
+
+    for (size_t i = 0; i < sizeof(header); i++) {
+        uart_poll_out(uart, header[i]);
+    }
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart, data[i]);
+    }
+    for (size_t i = 0; i < sizeof(trailer); i++) {
+        uart_poll_out(uart, trailer[i]);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC) */
+
+    return 0;
+}
+
+static int split_wired_init(const struct device *_arg) {
+    if (!device_is_ready(uart)) {
+        LOG_ERR("Split UART %s is not ready", uart->name);
+        return -ENODEV;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC)
+    int err = uart_callback_set(uart, uart_callback, NULL);
+    if (err) {
+        LOG_ERR("Failed to set the split UART callback (err %d)", err);
+        return err;
+    }
+
+    err = start_rx();
+    if (err) {
+        LOG_ERR("Failed to start receiving on the split UART (err %d)", err);
+        return err;
+    }
+#else
+    k_work_schedule(&poll_work, K_NO_WAIT);
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_ASYNC) */
+
+    return 0;
+}
+
+SYS_INIT(split_wired_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <kernel.h>
+#include <init.h>
+#include <string.h>
+#include <sys/atomic.h>
+#include <sys/byteorder.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/hid.h>
+#include <zmk/telemetry.h>
+#include <zmk/events/position_state_changed.h>
+
+#if IS_ENABLED(CONFIG_ZMK_USB)
+#include <zmk/usb.h>
+#include <zmk/usb_hid.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+#include <zmk/hog.h>
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+#include <zmk/latency.h>
+#endif
+
+BUILD_ASSERT(sizeof(struct zmk_telemetry_counters_frame) <= ZMK_HID_TELEMETRY_PAYLOAD_SIZE);
+BUILD_ASSERT(sizeof(struct zmk_telemetry_latency_frame) <= ZMK_HID_TELEMETRY_PAYLOAD_SIZE);
+BUILD_ASSERT(sizeof(struct zmk_telemetry_histogram_frame) <= ZMK_HID_TELEMETRY_PAYLOAD_SIZE);
+
+// Frames of one round are spaced out, so they don't fill up the report queues in one go.
+#define FRAME_SPACING K_MSEC(10)
+
+static atomic_t counters[ZMK_TELEMETRY_COUNTER_COUNT];
+static atomic_t queue_high_water[ZMK_TELEMETRY_QUEUE_COUNT];
+
+void zmk_telemetry_add(enum zmk_telemetry_counter counter, uint32_t value) {
+    atomic_add(&counters[counter], value);
+}
+
+void zmk_telemetry_queue_used(enum zmk_telemetry_queue queue, uint32_t used) {
+    atomic_val_t high_water;
+    do {
+        high_water = atomic_get(&queue_high_water[queue]);
+        if (used <= high_water) {
+            return;
+        }
+    } while (!atomic_cas(&queue_high_water[queue], high_water, used));
+}
+
+static uint8_t sequence;
+
+static void send_frame(uint8_t type, const void *payload, size_t len) {
+    struct zmk_hid_telemetry_report report = {
+        .report_id = ZMK_HID_REPORT_ID_TELEMETRY,
+        .body = {.type = type, .sequence = sequence++},
+    };
+    memcpy(report.body.payload, payload, len);
+
+#if IS_ENABLED(CONFIG_ZMK_USB)
+    // Sending while suspended would wake the host up.
+    if (zmk_usb_is_hid_ready()) {
+        zmk_usb_hid_send_report((uint8_t *)&report, sizeof(report));
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    zmk_hog_send_telemetry_report(&report.body);
+#endif
+}
+
+static void send_counters_frame() {
+    struct zmk_telemetry_counters_frame frame = {
+        .uptime_ms = sys_cpu_to_le32(k_uptime_get_32()),
+    };
+
+    for (int i = 0; i < ZMK_TELEMETRY_COUNTER_COUNT; i++) {
+        frame.counters[i] = sys_cpu_to_le32(atomic_get(&counters[i]));
+    }
+    for (int i = 0; i < ZMK_TELEMETRY_QUEUE_COUNT; i++) {
+        frame.queue_high_water[i] = MIN(atomic_get(&queue_high_water[i]), UINT8_MAX);
+    }
+
+    send_frame(ZMK_TELEMETRY_FRAME_COUNTERS, &frame, sizeof(frame));
+}
+
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+
+#define HISTOGRAM_FRAMES                                                                           \
+    DIV_ROUND_UP(CONFIG_ZMK_LATENCY_PROBE_BUCKETS, ZMK_TELEMETRY_HISTOGRAM_FRAME_BUCKETS)
+
+// Each latency source takes one summary frame followed by its histogram.
+#define FRAMES_PER_SOURCE (1 + HISTOGRAM_FRAMES)
+
+static uint8_t latency_source(int index) {
+    return index == 0 ? ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL : index - 1;
+}
+
+// Returns false once there are no more sources.
+static bool send_latency_frame(int frame_index) {
+    uint8_t source = latency_source(frame_index / FRAMES_PER_SOURCE);
+    int histogram_frame = frame_index % FRAMES_PER_SOURCE - 1;
+
+    if (histogram_frame < 0) {
+        struct zmk_latency_stats stats;
+        if (zmk_latency_get_stats(source, &stats) < 0) {
+            return false;
+        }
+
+        struct zmk_telemetry_latency_frame frame = {
+            .source = source,
+            .count = sys_cpu_to_le32(stats.count),
+            .min_us = sys_cpu_to_le32(stats.min_us),
+            .avg_us = sys_cpu_to_le32(stats.avg_us),
+            .p99_us = sys_cpu_to_le32(stats.p99_us),
+            .max_us = sys_cpu_to_le32(stats.max_us),
+        };
+        send_frame(ZMK_TELEMETRY_FRAME_LATENCY, &frame, sizeof(frame));
+        return true;
+    }
+
+    uint32_t buckets[CONFIG_ZMK_LATENCY_PROBE_BUCKETS];
+    int bucket_count = zmk_latency_get_histogram(source, buckets, ARRAY_SIZE(buckets));
+    if (bucket_count < 0) {
+        return false;
+    }
+
+    int first_bucket = histogram_frame * ZMK_TELEMETRY_HISTOGRAM_FRAME_BUCKETS;
+    struct zmk_telemetry_histogram_frame frame = {
+        .source = source,
+        .first_bucket = first_bucket,
+        .bucket_count = MIN(bucket_count - first_bucket, ZMK_TELEMETRY_HISTOGRAM_FRAME_BUCKETS),
+        .bucket_width_us = sys_cpu_to_le16(CONFIG_ZMK_LATENCY_PROBE_BUCKET_US),
+    };
+    for (int i = 0; i < frame.bucket_count; i++) {
+        frame.buckets[i] = sys_cpu_to_le16(MIN(buckets[first_bucket + i], UINT16_MAX));
+    }
+
+    send_frame(ZMK_TELEMETRY_FRAME_LATENCY_HISTOGRAM, &frame, sizeof(frame));
+    return true;
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE) */
+
+// Index of the next frame in the current round, the counters frame being the first.
+static int round_frame;
+
+static void telemetry_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    bool round_done = true;
+
+    if (round_frame == 0) {
+        send_counters_frame();
+        round_done = !IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE);
+    }
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    else {
+        round_done = !send_latency_frame(round_frame - 1);
+    }
+#endif
+
+    if (round_done) {
+        round_frame = 0;
+        k_work_schedule(dwork, K_MSEC(CONFIG_ZMK_TELEMETRY_INTERVAL));
+    } else {
+        round_frame++;
+        k_work_schedule(dwork, FRAME_SPACING);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(telemetry_work, telemetry_work_handler);
+
+static int zmk_telemetry_init(const struct device *_arg) {
+    k_work_schedule(&telemetry_work, K_MSEC(CONFIG_ZMK_TELEMETRY_INTERVAL));
+    return 0;
+}
+
+SYS_INIT(zmk_telemetry_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
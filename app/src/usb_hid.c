@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdlib.h>
 #include <device.h>
 #include <init.h>
 
@@ -13,21 +14,424 @@
 #include <zmk/usb.h>
 #include <zmk/hid.h>
 #include <zmk/keymap.h>
+#include <zmk/latency.h>
+#include <zmk/telemetry.h>
 #include <zmk/event_manager.h>
+#include <zmk/events/usb_conn_state_changed.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 static const struct device *hid_dev;
 
-static K_SEM_DEFINE(hid_sem, 1, 1);
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+#define USB_HID_MAX_REPORT_ID ZMK_HID_REPORT_ID_TELEMETRY
+#elif IS_ENABLED(CONFIG_ZMK_MOUSE)
+#define USB_HID_MAX_REPORT_ID ZMK_HID_REPORT_ID_MOUSE
+#else
+#define USB_HID_MAX_REPORT_ID ZMK_HID_REPORT_ID_CONSUMER
+#endif
 
-static void in_ready_cb(const struct device *dev) { k_sem_give(&hid_sem); }
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+#define USB_HID_MOUSE_REPORT_SIZE sizeof(struct zmk_hid_mouse_report)
+#else
+#define USB_HID_MOUSE_REPORT_SIZE 0
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+#define USB_HID_TELEMETRY_REPORT_SIZE sizeof(struct zmk_hid_telemetry_report)
+#else
+#define USB_HID_TELEMETRY_REPORT_SIZE 0
+#endif
+
+#define USB_HID_MAX_REPORT_SIZE                                                                    \
+    MAX(MAX(sizeof(struct zmk_hid_keyboard_report), sizeof(struct zmk_hid_consumer_report)),       \
+        MAX(USB_HID_MOUSE_REPORT_SIZE, USB_HID_TELEMETRY_REPORT_SIZE))
+
+#define USB_HID_QUEUE_SIZE CONFIG_ZMK_USB_HID_REPORT_QUEUE_SIZE
+
+BUILD_ASSERT(sizeof(struct zmk_hid_keyboard_report) <= CONFIG_HID_INTERRUPT_EP_MPS,
+             "The keyboard report doesn't fit in the HID interrupt endpoint");
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+BUILD_ASSERT(sizeof(struct zmk_hid_telemetry_report) <= CONFIG_HID_INTERRUPT_EP_MPS,
+             "The telemetry report doesn't fit in the HID interrupt endpoint");
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_HIGH_RATE)
+BUILD_ASSERT(CONFIG_USB_HID_POLL_INTERVAL_MS == 1,
+             "High-rate USB HID reporting requires a 1 ms polling interval");
+#endif
+
+struct usb_hid_report {
+    // Orders reports across the queues, so they reach the host in the order they were queued.
+    uint32_t sequence;
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    // The newest keycode change the report carries
+    uint32_t keycode_sequence;
+#endif
+    uint8_t len;
+    uint8_t data[USB_HID_MAX_REPORT_SIZE];
+};
+
+// Oldest report first. There's room for one report over the limit, so a new report can be queued
+// before working out which two to merge.
+struct usb_hid_report_queue {
+    struct usb_hid_report reports[USB_HID_QUEUE_SIZE + 1];
+    uint8_t count;
+};
+
+// One queue per report ID, indexed by report ID - 1.
+static struct usb_hid_report_queue report_queues[USB_HID_MAX_REPORT_ID];
+static uint32_t next_sequence;
+
+// The last report of each ID the host has received.
+static struct usb_hid_report sent_reports[USB_HID_MAX_REPORT_ID];
+
+// Second buffer, owned by the endpoint while a transfer is in flight, so callers can keep queueing
+// reports without touching the data being sent.
+static struct usb_hid_report in_flight_report;
+static bool in_flight;
+
+// Protects the queues and in_flight, which are also accessed from the IN endpoint callback.
+static struct k_spinlock queue_lock;
+
+// The report the host will have before the one at index, which for the oldest queued report is
+// the one being sent, if it has the same ID.
+static const struct usb_hid_report *previous_report(const struct usb_hid_report_queue *queue,
+                                                    uint8_t report_id, uint8_t index) {
+    if (index > 0) {
+        return &queue->reports[index - 1];
+    }
+
+    if (in_flight && in_flight_report.data[0] == report_id) {
+        return &in_flight_report;
+    }
+
+    return &sent_reports[report_id - 1];
+}
+
+static void remove_report(struct usb_hid_report_queue *queue, uint8_t index) {
+    memmove(&queue->reports[index], &queue->reports[index + 1],
+            (queue->count - index - 1) * sizeof(queue->reports[0]));
+    queue->count--;
+}
+
+static bool report_is_subset(uint8_t report_id, const struct usb_hid_report *report,
+                             const struct usb_hid_report *other) {
+    switch (report_id) {
+    case ZMK_HID_REPORT_ID_KEYBOARD:
+        return zmk_hid_keyboard_report_is_subset(
+            &((const struct zmk_hid_keyboard_report *)report->data)->body,
+            &((const struct zmk_hid_keyboard_report *)other->data)->body);
+    case ZMK_HID_REPORT_ID_CONSUMER:
+        return zmk_hid_consumer_report_is_subset(
+            &((const struct zmk_hid_consumer_report *)report->data)->body,
+            &((const struct zmk_hid_consumer_report *)other->data)->body);
+    default:
+        return false;
+    }
+}
+
+// A key state is redundant if it lies between its neighbours, e.g. another key was pressed on the
+// way to it and one more after it. Dropping it batches those presses into one report, but doesn't
+// hide any transition.
+static bool report_is_redundant(uint8_t report_id, const struct usb_hid_report *prev,
+                                const struct usb_hid_report *report,
+                                const struct usb_hid_report *next) {
+    return (report_is_subset(report_id, prev, report) &&
+            report_is_subset(report_id, report, next)) ||
+           (report_is_subset(report_id, next, report) &&
+            report_is_subset(report_id, report, prev));
+}
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+static struct zmk_hid_mouse_report_body *mouse_report_body(struct usb_hid_report *report) {
+    return &((struct zmk_hid_mouse_report *)report->data)->body;
+}
+
+static bool merge_mouse_reports(struct usb_hid_report *report, struct usb_hid_report *next) {
+    struct zmk_hid_mouse_report_body *body = mouse_report_body(report);
+    struct zmk_hid_mouse_report_body *next_body = mouse_report_body(next);
+
+    return body->buttons == next_body->buttons && zmk_hid_mouse_report_merge(body, next_body);
+}
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+// Brings a queue that's one over its limit back to it. Key states are complete, so a redundant one
+// can go. Mouse movement is relative, so reports are merged by summing it.
+static void compact_queue(uint8_t report_id, struct usb_hid_report_queue *queue) {
+    uint8_t newest = queue->count - 1;
+
+    switch (report_id) {
+    case ZMK_HID_REPORT_ID_KEYBOARD:
+    case ZMK_HID_REPORT_ID_CONSUMER:
+        // Prefer the latest redundant state, so older transitions go out as they happened.
+        for (int i = newest - 1; i >= 0; i--) {
+            if (report_is_redundant(report_id, previous_report(queue, report_id, i),
+                                    &queue->reports[i], &queue->reports[i + 1])) {
+                remove_report(queue, i);
+                zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+                return;
+            }
+        }
+
+        // Every queued state undoes the one before it. The newest state still wins, so no key is
+        // left stuck, but the host misses a tap.
+        LOG_WRN("USB HID report %d queue full of alternating states, merging the newest two",
+                report_id);
+        remove_report(queue, newest - 1);
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, 1);
+        return;
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    case ZMK_HID_REPORT_ID_MOUSE:
+        for (int i = newest - 1; i >= 0; i--) {
+            if (merge_mouse_reports(&queue->reports[i], &queue->reports[i + 1])) {
+                remove_report(queue, i + 1);
+                zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+                return;
+            }
+        }
+
+        // Every queued report changes the buttons. The movement still adds up, but the host misses
+        // a click.
+        if (zmk_hid_mouse_report_merge(mouse_report_body(&queue->reports[newest - 1]),
+                                       mouse_report_body(&queue->reports[newest]))) {
+            LOG_WRN("USB HID mouse report queue full of button changes, merging the newest two");
+            remove_report(queue, newest);
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, 1);
+            return;
+        }
+        break;
+#endif /* IS_ENABLED(CONFIG_ZMK_MOUSE) */
+
+    default:
+        break;
+    }
+
+    LOG_WRN("USB HID report %d queue full, dropping oldest report", report_id);
+    remove_report(queue, 0);
+    if (report_id != ZMK_HID_REPORT_ID_TELEMETRY) {
+        zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, 1);
+    }
+}
+
+static void enqueue_report(const uint8_t *report, size_t len) {
+    uint8_t report_id = report[0];
+    struct usb_hid_report_queue *queue = &report_queues[report_id - 1];
+
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_HIGH_RATE)
+    // If the newest queued keyboard report and this one only add presses to the report before
+    // it, replace it and let the next poll carry the latest state, instead of spending one poll
+    // per intermediate state. A newest report that released something has to reach the host as
+    // it is. It also has to be the last report queued of any ID, to keep reports in order.
+    if (report_id == ZMK_HID_REPORT_ID_KEYBOARD && queue->count > 0) {
+        uint8_t newest_index = queue->count - 1;
+        struct usb_hid_report *newest = &queue->reports[newest_index];
+        if (newest->sequence == next_sequence - 1 &&
+            report_is_subset(report_id, previous_report(queue, report_id, newest_index), newest) &&
+            zmk_hid_keyboard_report_is_subset(
+                &((const struct zmk_hid_keyboard_report *)newest->data)->body,
+                &((const struct zmk_hid_keyboard_report *)report)->body)) {
+            memcpy(newest->data, report, len);
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+            newest->keycode_sequence = zmk_latency_keycode_sequence();
+#endif
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SUPPRESSED, 1);
+            return;
+        }
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_USB_HID_HIGH_RATE) */
+
+    struct usb_hid_report *slot = &queue->reports[queue->count++];
+    slot->sequence = next_sequence++;
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    slot->keycode_sequence = zmk_latency_keycode_sequence();
+#endif
+    slot->len = len;
+    memcpy(slot->data, report, len);
+
+    if (queue->count > USB_HID_QUEUE_SIZE) {
+        compact_queue(report_id, queue);
+    }
+
+    zmk_telemetry_queue_used(ZMK_TELEMETRY_QUEUE_USB, queue->count);
+}
+
+static bool dequeue_report(struct usb_hid_report *report) {
+    struct usb_hid_report_queue *oldest = NULL;
+
+    for (int i = 0; i < ARRAY_SIZE(report_queues); i++) {
+        struct usb_hid_report_queue *queue = &report_queues[i];
+        if (queue->count > 0 &&
+            (oldest == NULL ||
+             (int32_t)(queue->reports[0].sequence - oldest->reports[0].sequence) < 0)) {
+            oldest = queue;
+        }
+    }
+
+    if (oldest == NULL) {
+        return false;
+    }
+
+    *report = oldest->reports[0];
+    remove_report(oldest, 0);
+    return true;
+}
+
+// Puts back a report that couldn't be written, so it goes out first on the next attempt.
+static void requeue_report(const struct usb_hid_report *report) {
+    uint8_t report_id = report->data[0];
+    struct usb_hid_report_queue *queue = &report_queues[report_id - 1];
+
+    memmove(&queue->reports[1], &queue->reports[0], queue->count * sizeof(queue->reports[0]));
+    queue->reports[0] = *report;
+    queue->count++;
+
+    if (queue->count > USB_HID_QUEUE_SIZE) {
+        compact_queue(report_id, queue);
+    }
+}
+
+static int write_next_report() {
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+    bool claimed = !in_flight && dequeue_report(&in_flight_report);
+    if (claimed) {
+        in_flight = true;
+    }
+    k_spin_unlock(&queue_lock, key);
+
+    if (!claimed) {
+        return 0;
+    }
+
+    // The buffer can be reused as soon as the transfer completes, which may be before the write
+    // returns.
+    uint8_t report_id = in_flight_report.data[0];
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    uint32_t keycode_sequence = in_flight_report.keycode_sequence;
+#endif
+
+    int err = hid_int_ep_write(hid_dev, in_flight_report.data, in_flight_report.len, NULL);
+    if (err) {
+        key = k_spin_lock(&queue_lock);
+        // Cleared first, so the report isn't compared against itself when its queue is compacted.
+        in_flight = false;
+        requeue_report(&in_flight_report);
+        k_spin_unlock(&queue_lock, key);
+        return err;
+    }
+
+    if (report_id == ZMK_HID_REPORT_ID_TELEMETRY) {
+        return 0;
+    }
+
+    zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_SENT, 1);
+
+#if IS_ENABLED(CONFIG_ZMK_LATENCY_PROBE)
+    if (report_id == ZMK_HID_REPORT_ID_KEYBOARD) {
+        zmk_latency_report_sent(HID_USAGE_KEY, keycode_sequence);
+    } else if (report_id == ZMK_HID_REPORT_ID_CONSUMER) {
+        zmk_latency_report_sent(HID_USAGE_CONSUMER, keycode_sequence);
+    }
+#endif
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT)
+
+// Intervals are only measured between completions of reports that were written back to back, i.e.
+// the next report was already queued when the previous transfer completed. Those are limited by
+// the host polling rate rather than by how fast keys are pressed.
+struct usb_hid_rate_stats {
+    uint32_t reports;
+    uint32_t intervals;
+    uint64_t interval_sum_us;
+    uint32_t interval_min_us;
+    uint32_t interval_max_us;
+    uint64_t deviation_sum_us;
+};
+
+static struct usb_hid_rate_stats rate_stats = {.interval_min_us = UINT32_MAX};
+static uint32_t last_completion_cycles;
+static bool last_write_back_to_back;
+
+static void record_completion() {
+    uint32_t now = k_cycle_get_32();
+
+    rate_stats.reports++;
+    if (last_write_back_to_back) {
+        uint32_t interval_us = k_cyc_to_us_floor32(now - last_completion_cycles);
+        int32_t deviation_us = interval_us - CONFIG_USB_HID_POLL_INTERVAL_MS * USEC_PER_MSEC;
+
+        rate_stats.intervals++;
+        rate_stats.interval_sum_us += interval_us;
+        rate_stats.interval_min_us = MIN(rate_stats.interval_min_us, interval_us);
+        rate_stats.interval_max_us = MAX(rate_stats.interval_max_us, interval_us);
+        rate_stats.deviation_sum_us += abs(deviation_us);
+    }
+
+    last_completion_cycles = now;
+}
+
+static void rate_stats_log_work_handler(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+    struct usb_hid_rate_stats stats = rate_stats;
+    rate_stats = (struct usb_hid_rate_stats){.interval_min_us = UINT32_MAX};
+    k_spin_unlock(&queue_lock, key);
+
+    if (stats.intervals == 0) {
+        LOG_INF("%u reports sent, none back to back", stats.reports);
+    } else {
+        uint32_t average_us = stats.interval_sum_us / stats.intervals;
+        LOG_INF("%u reports sent, %u back to back: %u reports/s, interval avg %u min %u max %u us, "
+                "jitter %u us",
+                stats.reports, stats.intervals, USEC_PER_SEC / MAX(average_us, 1), average_us,
+                stats.interval_min_us, stats.interval_max_us,
+                (uint32_t)(stats.deviation_sum_us / stats.intervals));
+    }
+
+    k_work_schedule(k_work_delayable_from_work(work),
+                    K_SECONDS(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT_INTERVAL));
+}
+
+static K_WORK_DELAYABLE_DEFINE(rate_stats_log_work, rate_stats_log_work_handler);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT) */
+
+static void in_ready_cb(const struct device *dev) {
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+    if (in_flight) {
+        sent_reports[in_flight_report.data[0] - 1] = in_flight_report;
+        in_flight = false;
+    }
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT)
+    record_completion();
+#endif
+    k_spin_unlock(&queue_lock, key);
+
+    int err = write_next_report();
+    if (err) {
+        LOG_ERR("Failed to write queued HID report (%d)", err);
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT)
+    key = k_spin_lock(&queue_lock);
+    last_write_back_to_back = in_flight;
+    k_spin_unlock(&queue_lock, key);
+#endif
+}
 
 static const struct hid_ops ops = {
     .int_in_ready = in_ready_cb,
 };
 
 int zmk_usb_hid_send_report(const uint8_t *report, size_t len) {
+    if (len > USB_HID_MAX_REPORT_SIZE || report[0] == 0 || report[0] > USB_HID_MAX_REPORT_ID) {
+        return -EINVAL;
+    }
+
     switch (zmk_usb_get_status()) {
     case USB_DC_SUSPEND:
         return usb_wakeup_request();
@@ -36,18 +440,41 @@ int zmk_usb_hid_send_report(const uint8_t *report, size_t len) {
     case USB_DC_DISCONNECTED:
     case USB_DC_UNKNOWN:
         return -ENODEV;
-    default:
-        k_sem_take(&hid_sem, K_MSEC(30));
-        int err = hid_int_ep_write(hid_dev, report, len, NULL);
+    default: {
+        k_spinlock_key_t key = k_spin_lock(&queue_lock);
+        enqueue_report(report, len);
+        k_spin_unlock(&queue_lock, key);
 
-        if (err) {
-            k_sem_give(&hid_sem);
-        }
+        return write_next_report();
+    }
+    }
+}
 
-        return err;
+static int usb_hid_listener(const zmk_event_t *eh) {
+    const struct zmk_usb_conn_state_changed *ev = as_zmk_usb_conn_state_changed(eh);
+
+    if (ev->conn_state == ZMK_USB_CONN_HID) {
+        return 0;
     }
+
+    // Transfers don't complete once the host is gone, so nothing queued would ever be sent.
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+    for (int i = 0; i < ARRAY_SIZE(report_queues); i++) {
+        if (i + 1 != ZMK_HID_REPORT_ID_TELEMETRY) {
+            zmk_telemetry_add(ZMK_TELEMETRY_REPORTS_DROPPED, report_queues[i].count);
+        }
+    }
+    memset(report_queues, 0, sizeof(report_queues));
+    memset(sent_reports, 0, sizeof(sent_reports));
+    in_flight = false;
+    k_spin_unlock(&queue_lock, key);
+
+    return 0;
 }
 
+ZMK_LISTENER(usb_hid, usb_hid_listener);
+ZMK_SUBSCRIPTION(usb_hid, zmk_usb_conn_state_changed);
+
 static int zmk_usb_hid_init(const struct device *_arg) {
     hid_dev = device_get_binding("HID_0");
     if (hid_dev == NULL) {
@@ -58,6 +485,10 @@ static int zmk_usb_hid_init(const struct device *_arg) {
     usb_hid_register_device(hid_dev, zmk_hid_report_desc, sizeof(zmk_hid_report_desc), &ops);
     usb_hid_init(hid_dev);
 
+#if IS_ENABLED(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT)
+    k_work_schedule(&rate_stats_log_work, K_SECONDS(CONFIG_ZMK_USB_HID_RATE_MEASUREMENT_INTERVAL));
+#endif
+
     return 0;
 }
 
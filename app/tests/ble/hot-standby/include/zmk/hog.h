@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+// Stands in for the real HOG header, which would pull in the whole HID layer.
+
+#include <bluetooth/conn.h>
+
+int zmk_hog_send_release_reports(struct bt_conn *conn);
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <ztest.h>
+
+#include "stubs.h"
+
+// Included rather than linked, so the tests can reach its static state and callbacks.
+#include "../../../../src/ble.c"
+
+static void reset_ble(void) {
+    set_active_profile_conn(NULL);
+    stub_reset();
+
+    for (int i = 0; i < ZMK_BLE_PROFILE_COUNT; i++) {
+        bt_addr_le_copy(&profiles[i].peer, BT_ADDR_LE_ANY);
+    }
+    active_profile = 0;
+    advertising_status = ZMK_ADV_NONE;
+}
+
+static void bond_profile(uint8_t index, uint8_t host) {
+    bt_addr_le_t addr = stub_host_addr(host);
+    bt_addr_le_copy(&profiles[index].peer, &addr);
+}
+
+static struct bt_conn *connect_host(uint8_t host) {
+    bt_addr_le_t addr = stub_host_addr(host);
+    struct bt_conn *conn = stub_connect(&addr);
+
+    connected(conn, 0);
+    return conn;
+}
+
+static void test_standby_slot_available(void) {
+    zassert_false(standby_slot_available(), "No host is bonded");
+
+    bond_profile(0, 1);
+    bond_profile(1, 2);
+    bond_profile(2, 3);
+    zassert_true(standby_slot_available(), "Bonded hosts aren't connected");
+
+    connect_host(1);
+    zassert_true(standby_slot_available(), "Only the active profile's host is connected");
+
+    connect_host(2);
+    zassert_false(standby_slot_available(),
+                  "CONFIG_ZMK_BLE_HOT_STANDBY_HOSTS hosts are already connected");
+}
+
+static void test_standby_slot_available_few_bonds(void) {
+    bond_profile(0, 1);
+    connect_host(1);
+
+    zassert_false(standby_slot_available(), "The only bonded host is connected");
+}
+
+static void test_unbonded_host_disconnected(void) {
+    bond_profile(0, 1);
+    bond_profile(1, 2);
+
+    connect_host(2);
+    zassert_equal(stub_disconnect_count, 0, "A bonded host was disconnected");
+
+    struct bt_conn *conn = connect_host(9);
+    zassert_equal(stub_disconnect_count, 1, "An unbonded host was kept connected");
+    zassert_equal_ptr(stub_disconnected_conn, conn, "The wrong host was disconnected");
+}
+
+static void test_unbonded_host_kept_on_open_profile(void) {
+    bond_profile(1, 2);
+
+    connect_host(9);
+    zassert_equal(stub_disconnect_count, 0, "A host pairing to the open profile was disconnected");
+}
+
+static void test_prof_select_releases_previous_host(void) {
+    bond_profile(0, 1);
+    bond_profile(1, 2);
+
+    struct bt_conn *conn = connect_host(1);
+    zassert_equal_ptr(active_profile_conn, conn, "The active profile's host isn't tracked");
+
+    zassert_equal(zmk_ble_prof_select(1), 0, "Profile select failed");
+    zassert_equal(stub_release_count, 1, "The previous host wasn't sent released reports");
+    zassert_equal_ptr(stub_released_conn, conn, "Released reports went to the wrong host");
+    zassert_is_null(active_profile_conn, "The new profile's host isn't connected");
+    zassert_equal(conn->refs, 1, "A reference to the previous host was leaked");
+}
+
+static void test_prof_select_without_previous_host(void) {
+    bond_profile(0, 1);
+    bond_profile(1, 2);
+
+    zassert_equal(zmk_ble_prof_select(1), 0, "Profile select failed");
+    zassert_equal(stub_release_count, 0, "Released reports were sent without a previous host");
+}
+
+void test_main(void) {
+    ztest_test_suite(ble_hot_standby,
+                     ztest_unit_test_setup_teardown(test_standby_slot_available, reset_ble,
+                                                    unit_test_noop),
+                     ztest_unit_test_setup_teardown(test_standby_slot_available_few_bonds,
+                                                    reset_ble, unit_test_noop),
+                     ztest_unit_test_setup_teardown(test_unbonded_host_disconnected, reset_ble,
+                                                    unit_test_noop),
+                     ztest_unit_test_setup_teardown(test_unbonded_host_kept_on_open_profile,
+                                                    reset_ble, unit_test_noop),
+                     ztest_unit_test_setup_teardown(test_prof_select_releases_previous_host,
+                                                    reset_ble, unit_test_noop),
+                     ztest_unit_test_setup_teardown(test_prof_select_without_previous_host,
+                                                    reset_ble, unit_test_noop));
+    ztest_run_test_suite(ble_hot_standby);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <bluetooth/bluetooth.h>
+#include <settings/settings.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/hog.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/ble_active_profile_changed.h>
+
+#include "stubs.h"
+
+const bt_addr_le_t bt_addr_le_any = {0, {{0, 0, 0, 0, 0, 0}}};
+
+struct bt_conn stub_conns[STUB_CONN_COUNT];
+
+struct bt_conn *stub_disconnected_conn;
+int stub_disconnect_count;
+struct bt_conn *stub_released_conn;
+int stub_release_count;
+
+void stub_reset() {
+    memset(stub_conns, 0, sizeof(stub_conns));
+    stub_disconnected_conn = NULL;
+    stub_disconnect_count = 0;
+    stub_released_conn = NULL;
+    stub_release_count = 0;
+}
+
+bt_addr_le_t stub_host_addr(uint8_t host) {
+    return (bt_addr_le_t){.type = BT_ADDR_LE_RANDOM, .a = {.val = {host, 0, 0, 0, 0, 0xc0}}};
+}
+
+struct bt_conn *stub_connect(const bt_addr_le_t *addr) {
+    for (int i = 0; i < STUB_CONN_COUNT; i++) {
+        if (!stub_conns[i].connected) {
+            bt_addr_le_copy(&stub_conns[i].dst, addr);
+            stub_conns[i].connected = true;
+            stub_conns[i].refs = 1;
+            return &stub_conns[i];
+        }
+    }
+
+    return NULL;
+}
+
+int bt_enable(bt_ready_cb_t cb) { return 0; }
+
+int bt_le_adv_start(const struct bt_le_adv_param *param, const struct bt_data *ad, size_t ad_len,
+                    const struct bt_data *sd, size_t sd_len) {
+    return 0;
+}
+
+int bt_le_adv_stop(void) { return 0; }
+
+int bt_unpair(uint8_t id, const bt_addr_le_t *addr) { return 0; }
+
+void bt_conn_cb_register(struct bt_conn_cb *cb) {}
+
+int bt_conn_auth_cb_register(const struct bt_conn_auth_cb *cb) { return 0; }
+
+struct bt_conn *bt_conn_ref(struct bt_conn *conn) {
+    conn->refs++;
+    return conn;
+}
+
+void bt_conn_unref(struct bt_conn *conn) { conn->refs--; }
+
+struct bt_conn *bt_conn_lookup_addr_le(uint8_t id, const bt_addr_le_t *peer) {
+    for (int i = 0; i < STUB_CONN_COUNT; i++) {
+        if (stub_conns[i].connected && !bt_addr_le_cmp(&stub_conns[i].dst, peer)) {
+            return bt_conn_ref(&stub_conns[i]);
+        }
+    }
+
+    return NULL;
+}
+
+const bt_addr_le_t *bt_conn_get_dst(const struct bt_conn *conn) { return &conn->dst; }
+
+int bt_conn_get_info(const struct bt_conn *conn, struct bt_conn_info *info) {
+    memset(info, 0, sizeof(*info));
+    info->type = BT_CONN_TYPE_LE;
+    info->role = BT_CONN_ROLE_PERIPHERAL;
+    info->id = BT_ID_DEFAULT;
+    info->le.dst = &conn->dst;
+    return 0;
+}
+
+int bt_conn_set_security(struct bt_conn *conn, bt_security_t sec) { return 0; }
+
+int bt_conn_disconnect(struct bt_conn *conn, uint8_t reason) {
+    stub_disconnected_conn = conn;
+    stub_disconnect_count++;
+    return 0;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len) { return 0; }
+
+int zmk_hog_send_release_reports(struct bt_conn *conn) {
+    stub_released_conn = conn;
+    stub_release_count++;
+    return 0;
+}
+
+struct zmk_ble_active_profile_changed_event *
+new_zmk_ble_active_profile_changed(struct zmk_ble_active_profile_changed data) {
+    static struct zmk_ble_active_profile_changed_event event;
+
+    event.data = data;
+    return &event;
+}
+
+int zmk_event_manager_raise(zmk_event_t *event) { return 0; }
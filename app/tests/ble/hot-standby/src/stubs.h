@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <bluetooth/addr.h>
+#include <bluetooth/conn.h>
+
+#define STUB_CONN_COUNT 4
+
+// A connection as the stubbed Bluetooth host sees it. refs includes the host's own reference.
+struct bt_conn {
+    bt_addr_le_t dst;
+    bool connected;
+    int refs;
+};
+
+extern struct bt_conn stub_conns[STUB_CONN_COUNT];
+
+// The last connection passed to bt_conn_disconnect and to zmk_hog_send_release_reports.
+extern struct bt_conn *stub_disconnected_conn;
+extern int stub_disconnect_count;
+extern struct bt_conn *stub_released_conn;
+extern int stub_release_count;
+
+void stub_reset();
+bt_addr_le_t stub_host_addr(uint8_t host);
+// Opens a connection from a host, without telling ble.c about it.
+struct bt_conn *stub_connect(const bt_addr_le_t *addr);
@@ -39,6 +39,7 @@ module.exports = {
       "behaviors/outputs",
       "behaviors/underglow",
       "behaviors/backlight",
+      "behaviors/mouse-emulation",
       "behaviors/power",
     ],
     Codes: [